@@ -0,0 +1,890 @@
+#pragma once
+
+#ifndef _EXTERNAL_SORTER_HPP_
+    #define _EXTERNAL_SORTER_HPP_
+
+    #include <span>
+    #include <array>
+    #include <tuple>
+    #include <vector>
+    #include <future>
+    #include <cstring>
+    #include <optional>
+    #include <stdexcept>
+    #include <algorithm>
+    #include <functional>
+
+    #include <Utilities/Utils.hpp>
+    #include <Utilities/Schema.hpp>
+    #include <Utilities/KeySort.hpp>
+    #include <Utilities/LoserTree.hpp>
+    #include <Utilities/TaskScheduler.hpp>
+    #include <Storage/BufferManager.hpp>
+    #include <Storage/SpaceManager.hpp>
+    #include <Storage/RecordView.hpp>
+
+/**
+ * External merge sort of fixed size records on any multi column key.
+ * Sorted runs are built one after another within a memory budget, the pairs of a key/pointer run sorted on several
+ * threads, and merged through a loser tree, as many at a time as the budget has pages, with every key range of the
+ * last pass merged on its own thread.
+ * Runs are read a page at a time with the next page of the run that runs out first read ahead, and the output is
+ * written from two pages in turn, so disk I/O overlaps the merge. The sort is stable.
+ */
+
+// Direction a column of a sort key is ordered in
+enum class SortOrder
+{
+    ASCENDING,
+    DESCENDING
+};
+
+// One column of a sort key, by position in the record's schema
+struct SortColumn
+{
+    size_t field;
+    SortOrder order = SortOrder::ASCENDING;
+};
+
+/**
+ * @brief Get the sort key column of a member.
+ * @tparam Member Pointer to the member, e.g. `&Employee::salary`.
+ * @param order Direction the column is ordered in.
+ * @return The column.
+ */
+template <auto Member>
+constexpr auto sortColumn(SortOrder order = SortOrder::ASCENDING) -> SortColumn
+{
+    return {fieldIndex<Member>(), order};
+}
+
+/**
+ * Multi column key of records of type `T`, ordering them column after column.
+ * Integer fields are compared as signed numbers and char array fields as NUL terminated strings of unsigned bytes.
+ * The key also maps a record to a 64 bit prefix of its normalized key, whose byte order is the key's order, so runs
+ * can be sorted as (prefix, index) pairs; the prefix is the whole key when the normalized key fits in 8 bytes.
+ * @tparam T Type of the records, described by a `Schema` specialization.
+ */
+template <typename T>
+class SortKey
+{
+    private:
+
+    // a key column with its field's layout
+    struct Column
+    {
+        size_t offset;
+        size_t width;
+        FieldKind kind;
+        bool descending;
+    };
+
+    // the columns, most significant first
+    std::vector<Column> columns;
+
+    // width of the normalized key in bytes
+    size_t width = 0;
+
+    public:
+
+    /**
+     * @brief Constructor
+     * @param keyColumns Columns of the key, most significant first.
+     * @throws std::invalid_argument if there is no column or a column is not a field of `T`.
+     */
+    explicit SortKey(std::vector<SortColumn> keyColumns)
+    {
+        if (keyColumns.empty())
+        {
+            throw std::invalid_argument("Sort key needs at least one column");
+        }
+        constexpr auto fields = fieldInfos<T>();
+        for (const auto &column : keyColumns)
+        {
+            if (column.field >= fields.size())
+            {
+                throw std::invalid_argument("Sort key column is not a field of the record");
+            }
+            const FieldInfo &field = fields[column.field];
+            columns.push_back({field.offset, field.width, field.kind, column.order == SortOrder::DESCENDING});
+            width += field.width;
+        }
+    }
+
+    /**
+     * @brief Get the key the schema sorts and joins records on, ascending.
+     * @return The key.
+     */
+    static auto schemaKey() -> SortKey
+    {
+        return SortKey({{fieldIndex<Schema<T>::Key::member>(), SortOrder::ASCENDING}});
+    }
+
+    /**
+     * @brief Compare two records.
+     * @return A negative number, 0 or a positive number as lhs orders before, with or after rhs.
+     */
+    auto compare(const T &lhs, const T &rhs) const -> int
+    {
+        const std::byte *left = reinterpret_cast<const std::byte *>(&lhs), *right = reinterpret_cast<const std::byte *>(&rhs);
+        for (const auto &column : columns)
+        {
+            int order = 0;
+            if (column.kind == FieldKind::INTEGER)
+            {
+                int64_t a = readInteger(left + column.offset, column.width), b = readInteger(right + column.offset, column.width);
+                order = (a > b) - (a < b);
+            }
+            else
+            {
+                order = std::strncmp(reinterpret_cast<const char *>(left + column.offset), reinterpret_cast<const char *>(right + column.offset), column.width);
+                order = (order > 0) - (order < 0);
+            }
+            if (order != 0)
+            {
+                return column.descending ? -order : order;
+            }
+        }
+        return 0;
+    }
+
+    // Strict weak order of the records, usable as the `less` of a `Sort` operator
+    auto operator()(const T &lhs, const T &rhs) const -> bool
+    {
+        return compare(lhs, rhs) < 0;
+    }
+
+    /**
+     * @brief Get the first 8 bytes of a record's normalized key, most significant first.
+     * @param record The record.
+     * @return The prefix, a smaller prefix means the record orders first.
+     */
+    auto prefix(const T &record) const -> uint64_t
+    {
+        const std::byte *bytes = reinterpret_cast<const std::byte *>(&record);
+        uint64_t prefix = 0;
+        size_t filled = 0;
+        for (const auto &column : columns)
+        {
+            const uint8_t invert = column.descending ? 0xff : 0x00;
+            if (column.kind == FieldKind::INTEGER)
+            {
+                // big endian with the sign bit flipped
+                uint64_t value = static_cast<uint64_t>(readInteger(bytes + column.offset, column.width)) ^ (uint64_t{1} << (column.width * 8 - 1));
+                for (size_t i = column.width; i-- > 0 && filled < sizeof(uint64_t); ++filled)
+                {
+                    prefix = (prefix << 8) | (static_cast<uint8_t>(value >> (i * 8)) ^ invert);
+                }
+            }
+            else
+            {
+                // bytes after the terminating NUL count as NUL
+                bool ended = false;
+                for (size_t i = 0; i < column.width && filled < sizeof(uint64_t); ++i, ++filled)
+                {
+                    uint8_t byte = ended ? 0 : static_cast<uint8_t>(bytes[column.offset + i]);
+                    ended = ended || byte == 0;
+                    prefix = (prefix << 8) | (byte ^ invert);
+                }
+            }
+            if (filled == sizeof(uint64_t))
+            {
+                return prefix;
+            }
+        }
+        return prefix << ((sizeof(uint64_t) - filled) * 8);
+    }
+
+    /**
+     * @brief Tells whether the prefix is the whole key, so equal prefixes mean equal keys.
+     * @return true when the normalized key fits in 8 bytes.
+     */
+    auto exact() const -> bool
+    {
+        return width <= sizeof(uint64_t);
+    }
+};
+
+// How sorted runs are built
+enum class RunFormation
+{
+    REPLACEMENT_SELECTION, // runs about twice the size of memory
+    KEY_POINTER            // memory sized runs, sorted as key/pointer pairs
+};
+
+// Reads a sorted run a page worth of records at a time, with room for one more page read ahead asynchronously
+template <typename T>
+class RunReader
+{
+    private:
+
+    // buffer manager holding the run
+    BufferManager *buffer_manager;
+
+    // address of the next record to load
+    address_id_t next;
+
+    // address one past the last record of the run
+    address_id_t end;
+
+    // records loaded from the current page
+    std::vector<T> records;
+
+    // current record in records
+    size_t position = 0;
+
+    // the page after the current one, while it is read ahead
+    std::optional<std::future<std::vector<T>>> ahead;
+
+    // Start reading the records of the page holding the next address, at least one record
+    auto readNext() -> std::function<std::vector<T>()>
+    {
+        const storage_t blockSize = buffer_manager->getBlockSize();
+        size_t count = std::max<size_t>(1, std::min((blockSize - next % blockSize) / sizeof(T), (end - next) / sizeof(T)));
+        address_id_t address = next;
+        next += count * sizeof(T);
+        return [buffer = buffer_manager, address, count]() {
+            auto data = buffer->readAddress(address, count * sizeof(T));
+            std::vector<T> block(count);
+            std::memcpy(block.data(), data.data(), count * sizeof(T));
+            return block;
+        };
+    }
+
+    // Move to the next page, the one read ahead if there is one
+    auto load() -> void
+    {
+        position = 0;
+        if (ahead.has_value())
+        {
+            records = TaskScheduler::global().get(ahead.value());
+            ahead.reset();
+        }
+        else
+        {
+            records = next + sizeof(T) <= end ? readNext()() : std::vector<T>{};
+        }
+    }
+
+    public:
+
+    RunReader(BufferManager &buffer, std::pair<address_id_t, address_id_t> run) : buffer_manager(&buffer), next(run.first), end(run.second)
+    {
+        load();
+    }
+
+    auto valid() const -> bool
+    {
+        return position < records.size();
+    }
+
+    auto get() const -> const T &
+    {
+        return records[position];
+    }
+
+    // Returns true when the current page ran out and the next one was loaded
+    auto advance() -> bool
+    {
+        if (++position == records.size())
+        {
+            load();
+            return true;
+        }
+        return false;
+    }
+
+    // Last record of the current page, the page runs out before any other page holding larger keys
+    auto last() const -> const T &
+    {
+        return records.back();
+    }
+
+    // Tells whether the run has a page left that is neither loaded nor being read ahead
+    auto canReadAhead() const -> bool
+    {
+        return valid() && !ahead.has_value() && next + sizeof(T) <= end;
+    }
+
+    // Start reading the next page in the background
+    auto readAhead() -> void
+    {
+        ahead = TaskScheduler::global().submit(readNext());
+    }
+};
+
+// Writes records a page at a time from two buffers, one filling while the other is written out in the background
+template <typename T>
+class RunWriter
+{
+    private:
+
+    // buffer manager the records go to
+    BufferManager *buffer_manager;
+
+    // address the next page is written to
+    address_id_t address;
+
+    // the two pages
+    std::array<std::vector<T>, 2> pages;
+
+    // page being filled
+    size_t current = 0;
+
+    // write of the other page, while in flight
+    std::optional<std::future<void>> writing;
+
+    // Wait for the page being written
+    auto wait() -> void
+    {
+        if (writing.has_value())
+        {
+            TaskScheduler::global().get(writing.value());
+            writing.reset();
+        }
+    }
+
+    // Write the page being filled in the background and start filling the other
+    auto flush() -> void
+    {
+        wait();
+        if (pages[current].empty())
+        {
+            return;
+        }
+        writing = TaskScheduler::global().submit([buffer = buffer_manager, at = address, page = &pages[current]]() {
+            buffer->writeAddress(at, std::as_bytes(std::span<const T>(*page)));
+        });
+        address += pages[current].size() * sizeof(T);
+        current ^= 1;
+        pages[current].clear();
+    }
+
+    public:
+
+    RunWriter(BufferManager &buffer, address_id_t start) : buffer_manager(&buffer), address(start)
+    {
+        for (auto &page : pages)
+        {
+            page.reserve(std::max<size_t>(1, buffer.getBlockSize() / sizeof(T)));
+        }
+    }
+
+    RunWriter(const RunWriter &) = delete;
+    RunWriter &operator=(const RunWriter &) = delete;
+
+    ~RunWriter()
+    {
+        try
+        {
+            wait();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    auto push(const T &record) -> void
+    {
+        pages[current].push_back(record);
+        if (pages[current].size() == pages[current].capacity())
+        {
+            flush();
+        }
+    }
+
+    // Write out what is left and wait for it, returns the address one past the last record
+    auto finish() -> address_id_t
+    {
+        flush();
+        wait();
+        return address;
+    }
+};
+
+// Records sorted by an `ExternalSorter`, in an extent the caller releases
+struct SortedExtent
+{
+    // blocks holding the records, from its start
+    Extent extent;
+
+    // address one past the last record
+    address_id_t end;
+};
+
+/**
+ * External merge sort of relations of records of type `T`.
+ * @tparam T Type of the records, described by a `Schema` specialization.
+ */
+template <typename T>
+class ExternalSorter
+{
+    public:
+
+    using RunList = std::vector<std::pair<address_id_t, address_id_t>>;
+
+    // Keys sampled per merge partition to pick the splitters
+    static constexpr size_t SAMPLES_PER_PARTITION = 32;
+
+    // Fewest key/pointer pairs per thread worth sorting a run on several threads
+    static constexpr size_t PARALLEL_SORT_ENTRIES = 1024;
+
+    private:
+
+    // buffer manager holding the input and the output
+    BufferManager *buffer_manager;
+
+    // space manager the output and the scratch space come from
+    SpaceManager *space_manager;
+
+    // order of the records
+    SortKey<T> key;
+
+    // number of threads building and merging runs
+    unsigned numThreads;
+
+    // bytes of records held in memory at once
+    storage_t memoryBudget;
+
+    // how runs are built
+    RunFormation formation;
+
+    /**
+     * Builds sorted runs by replacement selection: a heap of `capacity` records is kept full, the smallest record that
+     * can still extend the current run is written out and replaced by the next input record, which waits for the next
+     * run if it orders before the record just written. Runs come out about twice the size of memory on random input
+     * and as a single run on sorted input. Records stay in their slot from input to output, only compact key prefix
+     * entries move in the heap.
+     */
+    auto replacementSelection(address_id_t start, address_id_t end, address_id_t output, size_t capacity) const -> RunList
+    {
+        struct Entry
+        {
+            size_t run;
+            uint64_t prefix;
+            size_t sequence;
+            uint32_t slot;
+        };
+        capacity = std::max<size_t>(1, capacity);
+        std::vector<T> slots(capacity);
+
+        // Smallest (run, key) on top, ties broken by input order so runs are stable
+        const bool exact = key.exact();
+        auto greater = [&](const Entry &lhs, const Entry &rhs) {
+            if (lhs.run != rhs.run || lhs.prefix != rhs.prefix)
+            {
+                return std::tie(lhs.run, lhs.prefix) > std::tie(rhs.run, rhs.prefix);
+            }
+            int order = exact ? 0 : key.compare(slots[lhs.slot], slots[rhs.slot]);
+            return order != 0 ? order > 0 : lhs.sequence > rhs.sequence;
+        };
+        std::vector<Entry> heap;
+        heap.reserve(capacity);
+
+        RunList runs;
+        RunWriter<T> writer(*buffer_manager, output);
+        address_id_t runStart = output, written = output;
+        size_t sequence = 0;
+        RecordCursor<T> input(*buffer_manager, start, end);
+        for (; input.valid() && heap.size() < capacity; input.advance())
+        {
+            uint32_t slot = static_cast<uint32_t>(heap.size());
+            slots[slot] = input.get();
+            heap.push_back({0, key.prefix(slots[slot]), sequence++, slot});
+            std::push_heap(heap.begin(), heap.end(), greater);
+        }
+
+        size_t currentRun = 0;
+        while (!heap.empty())
+        {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            Entry smallest = heap.back();
+            heap.pop_back();
+            if (smallest.run != currentRun)
+            {
+                runs.push_back({runStart, written});
+                runStart = written;
+                currentRun = smallest.run;
+            }
+            writer.push(slots[smallest.slot]);
+            written += sizeof(T);
+            if (input.valid())
+            {
+                // the next record takes the slot just written out
+                const T &next = input.get();
+                size_t run = key.compare(next, slots[smallest.slot]) < 0 ? currentRun + 1 : currentRun;
+                slots[smallest.slot] = next;
+                heap.push_back({run, key.prefix(next), sequence++, smallest.slot});
+                std::push_heap(heap.begin(), heap.end(), greater);
+                input.advance();
+            }
+        }
+        writer.finish();
+        if (written > runStart)
+        {
+            runs.push_back({runStart, written});
+        }
+        return runs;
+    }
+
+    /**
+     * Sorts the key/pointer pairs of a run by key and then index. With several threads the pairs are cut into one
+     * slice per thread, every slice is sorted on its own, by radix when the prefix is the whole key, and the sorted
+     * slices are merged pairwise, each round's merges running at once.
+     */
+    auto sortEntries(std::vector<KeyPointer> &entries, const std::vector<T> &records, std::vector<KeyPointer> &scratch) const -> void
+    {
+        const bool exact = key.exact();
+        auto less = [&](const KeyPointer &lhs, const KeyPointer &rhs) {
+            if (lhs.prefix != rhs.prefix)
+            {
+                return lhs.prefix < rhs.prefix;
+            }
+            int order = exact ? 0 : key.compare(records[lhs.index], records[rhs.index]);
+            return order != 0 ? order < 0 : lhs.index < rhs.index;
+        };
+        auto sortSlice = [&](std::vector<KeyPointer> &slice, std::vector<KeyPointer> &sliceScratch) {
+            if (exact)
+            {
+                // pairs are in index order and the radix sort is stable
+                radixSortKeyPointers(slice, sliceScratch);
+            }
+            else
+            {
+                std::sort(slice.begin(), slice.end(), less);
+            }
+        };
+
+        const size_t numSlices = std::min<size_t>(numThreads, entries.size() / PARALLEL_SORT_ENTRIES + 1);
+        if (numSlices <= 1)
+        {
+            sortSlice(entries, scratch);
+            return;
+        }
+        std::vector<size_t> bounds;
+        for (size_t slice = 0; slice <= numSlices; ++slice)
+        {
+            bounds.push_back(entries.size() * slice / numSlices);
+        }
+        {
+            TaskGroup group;
+            for (size_t slice = 0; slice < numSlices; ++slice)
+            {
+                group.run([&, slice]() {
+                    std::vector<KeyPointer> part(entries.begin() + bounds[slice], entries.begin() + bounds[slice + 1]), partScratch;
+                    sortSlice(part, partScratch);
+                    std::copy(part.begin(), part.end(), entries.begin() + bounds[slice]);
+                });
+            }
+            group.wait();
+        }
+        scratch.resize(entries.size());
+        for (size_t width = 1; width < numSlices; width *= 2)
+        {
+            TaskGroup group;
+            for (size_t slice = 0; slice < numSlices; slice += 2 * width)
+            {
+                group.run([&, slice]() {
+                    const size_t first = bounds[slice], middle = bounds[std::min(numSlices, slice + width)], last = bounds[std::min(numSlices, slice + 2 * width)];
+                    std::merge(entries.begin() + first, entries.begin() + middle, entries.begin() + middle, entries.begin() + last, scratch.begin() + first, less);
+                });
+            }
+            group.wait();
+            entries.swap(scratch);
+        }
+    }
+
+    /**
+     * Builds memory sized runs: `capacity` records are loaded, their (key prefix, index) pairs are sorted, by radix
+     * when the prefix is the whole key, and the records are written out once, in sorted order.
+     */
+    auto keyPointerRuns(address_id_t start, address_id_t end, address_id_t output, size_t capacity) const -> RunList
+    {
+        capacity = std::max<size_t>(1, capacity);
+        std::vector<T> records, sorted;
+        std::vector<KeyPointer> entries, scratch;
+        records.reserve(capacity);
+        RunList runs;
+        RecordCursor<T> input(*buffer_manager, start, end);
+        while (input.valid())
+        {
+            records.clear();
+            entries.clear();
+            for (; input.valid() && records.size() < capacity; input.advance())
+            {
+                entries.push_back({key.prefix(input.get()), static_cast<uint32_t>(records.size())});
+                records.push_back(input.get());
+            }
+            sortEntries(entries, records, scratch);
+            sorted.resize(records.size());
+            gatherRecords<T>(entries, records, sorted);
+            bulkWrite(*buffer_manager, output, std::as_bytes(std::span<const T>(sorted)));
+            runs.push_back({output, output + sorted.size() * sizeof(T)});
+            output = runs.back().second;
+        }
+        return runs;
+    }
+
+    // Builds the runs one after another, each with the whole memory budget, so their number does not depend on the threads
+    auto generateRuns(address_id_t start, address_id_t end, address_id_t output) const -> RunList
+    {
+        const size_t capacity = memoryBudget / sizeof(T);
+        return formation == RunFormation::KEY_POINTER ? keyPointerRuns(start, end, output, capacity) : replacementSelection(start, end, output, capacity);
+    }
+
+    /**
+     * Merges sorted runs through a loser tree, ties go to the earlier run so the merge is stable.
+     * Only the run whose current page ends with the smallest key reads ahead, since its page runs out first.
+     */
+    auto mergeRuns(const RunList &runs, address_id_t output) const -> address_id_t
+    {
+        // current record of a run, ordered by prefix and then by the whole key
+        struct Head
+        {
+            uint64_t prefix;
+            const T *record;
+        };
+        auto less = [this, exact = key.exact()](const Head &lhs, const Head &rhs) {
+            if (lhs.prefix != rhs.prefix)
+            {
+                return lhs.prefix < rhs.prefix;
+            }
+            return !exact && key.compare(*lhs.record, *rhs.record) < 0;
+        };
+
+        std::vector<RunReader<T>> readers;
+        std::vector<Head> heads;
+        std::vector<bool> exhausted;
+        readers.reserve(runs.size());
+        for (const auto &run : runs)
+        {
+            readers.emplace_back(*buffer_manager, run);
+        }
+        for (const auto &reader : readers)
+        {
+            heads.push_back(reader.valid() ? Head{key.prefix(reader.get()), &reader.get()} : Head{0, nullptr});
+            exhausted.push_back(!reader.valid());
+        }
+
+        // one run reads ahead at a time
+        std::optional<size_t> readingAhead;
+        auto forecast = [&]() {
+            std::optional<size_t> first;
+            for (size_t r = 0; r < readers.size(); ++r)
+            {
+                if (readers[r].canReadAhead() && (!first.has_value() || key.compare(readers[r].last(), readers[first.value()].last()) < 0))
+                {
+                    first = r;
+                }
+            }
+            if (first.has_value())
+            {
+                readers[first.value()].readAhead();
+            }
+            readingAhead = first;
+        };
+        forecast();
+
+        RunWriter<T> writer(*buffer_manager, output);
+        LoserTree<Head, decltype(less)> tree(std::move(heads), std::move(exhausted), less);
+        while (!tree.empty())
+        {
+            size_t winner = tree.winner();
+            RunReader<T> &reader = readers[winner];
+            writer.push(reader.get());
+            if (reader.advance() && (!readingAhead.has_value() || readingAhead.value() == winner))
+            {
+                forecast();
+            }
+            if (reader.valid())
+            {
+                tree.replaceWinner({key.prefix(reader.get()), &reader.get()});
+            }
+            else
+            {
+                tree.exhaustWinner();
+            }
+        }
+        return writer.finish();
+    }
+
+    // Address of the first record of a sorted run that does not order before `splitter`
+    auto lowerBound(std::pair<address_id_t, address_id_t> run, const T &splitter) const -> address_id_t
+    {
+        size_t low = 0, high = (run.second - run.first) / sizeof(T);
+        while (low < high)
+        {
+            size_t middle = low + (high - low) / 2;
+            if (key.compare(extractData<T>(buffer_manager->readAddress(run.first + middle * sizeof(T), sizeof(T))), splitter) < 0)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        return run.first + low * sizeof(T);
+    }
+
+    // Number of merges of some runs that fit in the memory budget at once, each holds a page per run, the page read ahead and two output pages
+    auto concurrentMerges(size_t numRuns) const -> size_t
+    {
+        return std::clamp<size_t>(memoryBudget / buffer_manager->getBlockSize() / (numRuns + 3), 1, numThreads);
+    }
+
+    /**
+     * Merges sorted runs on several threads. Splitters picked from a sample of every run cut the key range into one
+     * partition per thread, every run is cut at the splitters by binary search and each partition is merged on its
+     * own into the place its output has in the result. Equal keys all fall in the same partition.
+     */
+    auto parallelMergeRuns(const RunList &runs, address_id_t output) const -> address_id_t
+    {
+        const size_t numPartitions = concurrentMerges(runs.size());
+        std::vector<T> sample;
+        const size_t samplesPerRun = (SAMPLES_PER_PARTITION * numPartitions + runs.size() - 1) / std::max<size_t>(1, runs.size());
+        for (const auto &run : runs)
+        {
+            const size_t count = (run.second - run.first) / sizeof(T);
+            for (size_t i = 0; numPartitions > 1 && count > 0 && i < samplesPerRun; ++i)
+            {
+                size_t index = count * (2 * i + 1) / (2 * samplesPerRun);
+                sample.push_back(extractData<T>(buffer_manager->readAddress(run.first + index * sizeof(T), sizeof(T))));
+            }
+        }
+        if (sample.empty())
+        {
+            return mergeRuns(runs, output);
+        }
+        std::sort(sample.begin(), sample.end(), key);
+
+        // cuts[p][r] is where partition p starts in run r, partition p orders from splitter p - 1 up to splitter p
+        std::vector<std::vector<address_id_t>> cuts(numPartitions + 1);
+        for (const auto &run : runs)
+        {
+            cuts.front().push_back(run.first);
+            cuts.back().push_back(run.second);
+        }
+        for (size_t partition = 1; partition < numPartitions; ++partition)
+        {
+            const T &splitter = sample[sample.size() * partition / numPartitions];
+            for (const auto &run : runs)
+            {
+                cuts[partition].push_back(lowerBound(run, splitter));
+            }
+        }
+
+        TaskGroup group;
+        for (size_t partition = 0; partition < numPartitions; ++partition)
+        {
+            RunList pieces;
+            const address_id_t partitionOutput = output;
+            for (size_t r = 0; r < runs.size(); ++r)
+            {
+                pieces.push_back({cuts[partition][r], cuts[partition + 1][r]});
+                output += cuts[partition + 1][r] - cuts[partition][r];
+            }
+            group.run([this, pieces = std::move(pieces), partitionOutput]() {
+                mergeRuns(pieces, partitionOutput);
+            });
+        }
+        group.wait();
+        return output;
+    }
+
+    public:
+
+    /**
+     * @brief Constructor
+     * @param buffer BufferManager holding the records, its pool size is the default memory budget.
+     * @param space SpaceManager the output and scratch space are allocated from.
+     * @param _key Order of the records, the schema key by default.
+     * @param _numThreads Number of threads building and merging runs, run as tasks of the shared `TaskScheduler`.
+     */
+    ExternalSorter(BufferManager &buffer, SpaceManager &space, SortKey<T> _key = SortKey<T>::schemaKey(), unsigned _numThreads = 1)
+        : buffer_manager(&buffer), space_manager(&space), key(std::move(_key)), numThreads(std::max(1u, _numThreads)),
+          memoryBudget(static_cast<storage_t>(buffer.getNumFrames()) * buffer.getBlockSize()),
+          formation(key.exact() ? RunFormation::KEY_POINTER : RunFormation::REPLACEMENT_SELECTION)
+    {
+    }
+
+    /**
+     * @brief Set the bytes of records held in memory at once, which also bounds the number of runs merged at once.
+     * @param bytes The budget, at least two pages are used.
+     */
+    auto setMemoryBudget(storage_t bytes) -> void
+    {
+        memoryBudget = std::max<storage_t>(bytes, 2 * buffer_manager->getBlockSize());
+    }
+
+    /**
+     * @brief Choose how runs are built, key/pointer runs are the default for keys whose prefix is exact.
+     * @param _formation The run formation.
+     */
+    auto setRunFormation(RunFormation _formation) -> void
+    {
+        formation = _formation;
+    }
+
+    /**
+     * @brief Sort a relation into newly allocated space, the input is left as it is.
+     * @param start Address of the first record (inclusive).
+     * @param end Address one past the last record (exclusive).
+     * @return The sorted records, from the start of the extent; release the extent once done with them.
+     * @throws std::runtime_error if the space manager cannot allocate twice the size of the input.
+     */
+    auto sort(address_id_t start, address_id_t end) -> SortedExtent
+    {
+        const storage_t dataSize = (end - start) / sizeof(T) * sizeof(T);
+        auto output = space_manager->allocate(dataSize);
+        if (!output.has_value())
+        {
+            throw std::runtime_error("Not enough free space for external sort");
+        }
+        auto scratch = space_manager->allocate(dataSize);
+        if (!scratch.has_value())
+        {
+            space_manager->release(output.value());
+            throw std::runtime_error("Not enough free space for external sort");
+        }
+
+        // runs are merged back and forth between the two extents, each run keeping its offset
+        Extent from = output.value(), to = scratch.value();
+        RunList runs = generateRuns(start, start + dataSize, from.start);
+        const size_t fanIn = std::max<size_t>(2, memoryBudget / buffer_manager->getBlockSize() - 1);
+        while (runs.size() > 1)
+        {
+            RunList merged;
+            if (runs.size() <= fanIn)
+            {
+                merged.push_back({to.start, parallelMergeRuns(runs, to.start)});
+            }
+            else
+            {
+                // only as many groups as the memory budget holds are merged at once
+                const size_t perWave = concurrentMerges(fanIn);
+                TaskGroup group;
+                for (size_t i = 0; i < runs.size(); i += fanIn)
+                {
+                    RunList groupRuns(runs.begin() + i, runs.begin() + std::min(runs.size(), i + fanIn));
+                    address_id_t groupStart = to.start + (groupRuns.front().first - from.start);
+                    merged.push_back({groupStart, groupStart + (groupRuns.back().second - groupRuns.front().first)});
+                    group.run([this, groupRuns = std::move(groupRuns), groupStart]() {
+                        mergeRuns(groupRuns, groupStart);
+                    });
+                    if (merged.size() % perWave == 0)
+                    {
+                        group.wait();
+                    }
+                }
+                group.wait();
+            }
+            runs = std::move(merged);
+            std::swap(from, to);
+        }
+        space_manager->release(to);
+        return {from, from.start + dataSize};
+    }
+};
+
+#endif // _EXTERNAL_SORTER_HPP_
@@ -0,0 +1,274 @@
+#pragma once
+
+#ifndef _GRACE_HASH_JOIN_HPP_
+    #define _GRACE_HASH_JOIN_HPP_
+
+    #include <vector>
+    #include <cstring>
+    #include <stdexcept>
+    #include <algorithm>
+    #include <functional>
+    #include <type_traits>
+    #include <unordered_map>
+
+    #include <Utilities/Utils.hpp>
+    #include <Utilities/Schema.hpp>
+    #include <Storage/BufferManager.hpp>
+    #include <Storage/SpaceManager.hpp>
+    #include <Storage/RecordView.hpp>
+    #include <Execution/ExternalSorter.hpp>
+
+// Deepest a partition is partitioned again
+inline constexpr size_t GRACE_MAX_DEPTH = 4;
+
+/**
+ * Grace hash join of two relations on their schema keys.
+ * Both inputs are cut by a hash of the key into `fanOut` partitions written to disk, so matching records land in
+ * partitions with the same number, and every pair of partitions is then joined with an in-memory hash table built on
+ * the right one. A right partition larger than the memory budget is partitioned again, with a differently seeded hash,
+ * until it fits; one whose records all share a bucket, e.g. a single heavily repeated key, is joined a memory worth of
+ * right records at a time instead. Each input is read, written and read back once whatever the buffer size, about
+ * three times its size in I/O, plus the output.
+ * @tparam L Type of the left (probe) records.
+ * @tparam R Type of the right (build) records, the smaller input.
+ * @tparam Out Type of the joined records, constructible from a left and a right record.
+ */
+template <typename L, typename R, typename Out>
+class GraceHashJoin
+{
+    static_assert(std::is_same_v<KeyType<L>, KeyType<R>>, "both inputs must have the same key type");
+
+    public:
+
+    using Key = KeyType<R>;
+
+    // Records of a partition as (address, count) chunks of records stored back to back
+    using Chunks = std::vector<std::pair<address_id_t, size_t>>;
+
+    private:
+
+    // buffer manager holding the inputs, the partitions and the output
+    BufferManager *buffer_manager;
+
+    // space manager the partitions are allocated from
+    SpaceManager *space_manager;
+
+    // bytes of right records held in memory at once
+    storage_t memoryBudget;
+
+    // number of partitions an input is cut into
+    size_t fanOut;
+
+    // Pages holding one chunk of records of type T, a page unless a record is larger
+    template <typename T>
+    auto chunkBytes() const -> storage_t
+    {
+        const storage_t blockSize = buffer_manager->getBlockSize();
+        return (sizeof(T) + blockSize - 1) / blockSize * blockSize;
+    }
+
+    // Number of records in some chunks
+    static auto countRecords(const Chunks &chunks) -> size_t
+    {
+        size_t count = 0;
+        for (const auto &chunk : chunks)
+        {
+            count += chunk.second;
+        }
+        return count;
+    }
+
+    // Visit every record of some chunks in place
+    template <typename T, typename Visit>
+    auto forEachRecord(const Chunks &chunks, Visit &&visit) const -> void
+    {
+        for (const auto &[address, count] : chunks)
+        {
+            for (RecordCursor<T> cursor(*buffer_manager, address, address + count * sizeof(T)); cursor.valid(); cursor.advance())
+            {
+                visit(cursor.get());
+            }
+        }
+    }
+
+    // Partition of a key at a recursion depth, every depth mixes the key with its own seed so a partition splits again
+    auto partitionOf(const Key &key, size_t depth) const -> size_t
+    {
+        uint64_t hash = std::hash<Key>{}(key) + 0x9e3779b97f4a7c15ULL * (depth + 1);
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+        return (hash ^ (hash >> 31)) % fanOut;
+    }
+
+    /**
+     * Cuts records into `fanOut` partitions. Every partition fills a chunk sized buffer that is written to the next free
+     * chunk of `extent` once full, so the partitions are written sequentially and a partition wastes at most its last
+     * chunk's tail.
+     */
+    template <typename T>
+    auto partition(const Chunks &input, size_t depth, const Extent &extent) const -> std::vector<Chunks>
+    {
+        const storage_t chunkSize = chunkBytes<T>();
+        const size_t perChunk = chunkSize / sizeof(T);
+        std::vector<std::vector<T>> buffers(fanOut);
+        std::vector<Chunks> partitions(fanOut);
+        std::vector<std::byte> chunk(chunkSize);
+        address_id_t nextChunk = extent.start;
+        auto flush = [&](size_t part) {
+            // whole chunks go straight to the disk, the tail of a partial one is left zeroed
+            std::fill(chunk.begin(), chunk.end(), std::byte{0});
+            std::memcpy(chunk.data(), buffers[part].data(), buffers[part].size() * sizeof(T));
+            bulkWrite(*buffer_manager, nextChunk, chunk);
+            partitions[part].push_back({nextChunk, buffers[part].size()});
+            nextChunk += chunkSize;
+            buffers[part].clear();
+        };
+
+        forEachRecord<T>(input, [&](const T &record) {
+            size_t part = partitionOf(keyOf(record), depth);
+            buffers[part].push_back(record);
+            if (buffers[part].size() == perChunk)
+            {
+                flush(part);
+            }
+        });
+        for (size_t part = 0; part < fanOut; ++part)
+        {
+            if (!buffers[part].empty())
+            {
+                flush(part);
+            }
+        }
+        return partitions;
+    }
+
+    // Allocate the space partitioning some records takes, every partition may waste one chunk
+    template <typename T>
+    auto allocatePartitions(size_t count) -> Extent
+    {
+        const size_t perChunk = chunkBytes<T>() / sizeof(T);
+        auto extent = space_manager->allocate(((count + perChunk - 1) / perChunk + fanOut) * chunkBytes<T>());
+        if (!extent.has_value())
+        {
+            throw std::runtime_error("Not enough free space for the hash join partitions");
+        }
+        return extent.value();
+    }
+
+    // Join with a hash table on the right records, built a memory budget at a time, each part probed by all left records
+    auto buildAndProbe(const Chunks &left, const Chunks &right, RunWriter<Out> &output) const -> void
+    {
+        std::unordered_map<Key, std::vector<R>> table;
+        size_t held = 0;
+        auto probe = [&]() {
+            forEachRecord<L>(left, [&](const L &record) {
+                auto it = table.find(keyOf(record));
+                if (it == table.end())
+                {
+                    return;
+                }
+                for (const R &match : it->second)
+                {
+                    output.push(Out(record, match));
+                }
+            });
+            table.clear();
+            held = 0;
+        };
+        forEachRecord<R>(right, [&](const R &record) {
+            table[keyOf(record)].push_back(record);
+            if (++held * sizeof(R) >= memoryBudget)
+            {
+                probe();
+            }
+        });
+        if (held > 0)
+        {
+            probe();
+        }
+    }
+
+    // Join a pair of partitions, partitioning them again while the right one does not fit in memory
+    auto joinPartitions(const Chunks &left, const Chunks &right, size_t depth, RunWriter<Out> &output) -> void
+    {
+        const size_t rightCount = countRecords(right);
+        if (rightCount * sizeof(R) <= memoryBudget || depth == GRACE_MAX_DEPTH)
+        {
+            buildAndProbe(left, right, output);
+            return;
+        }
+
+        // released on every way out, a deeper level may still run out of space
+        ExtentGuard leftExtent(*space_manager, allocatePartitions<L>(countRecords(left)));
+        ExtentGuard rightExtent(*space_manager, allocatePartitions<R>(rightCount));
+        auto rightPartitions = partition<R>(right, depth, rightExtent.get());
+        auto leftPartitions = partition<L>(left, depth, leftExtent.get());
+        for (size_t part = 0; part < fanOut; ++part)
+        {
+            if (leftPartitions[part].empty() || rightPartitions[part].empty())
+            {
+                continue;
+            }
+            // a partition the hash did not split would only be copied again
+            if (countRecords(rightPartitions[part]) == rightCount)
+            {
+                buildAndProbe(leftPartitions[part], rightPartitions[part], output);
+            }
+            else
+            {
+                joinPartitions(leftPartitions[part], rightPartitions[part], depth + 1, output);
+            }
+        }
+    }
+
+    public:
+
+    /**
+     * @brief Constructor
+     * @param buffer BufferManager holding the inputs, its pool size is the default memory budget.
+     * @param space SpaceManager the partitions are allocated from.
+     */
+    GraceHashJoin(BufferManager &buffer, SpaceManager &space)
+        : buffer_manager(&buffer), space_manager(&space), memoryBudget(static_cast<storage_t>(buffer.getNumFrames()) * buffer.getBlockSize()),
+          fanOut(std::max<size_t>(2, buffer.getNumFrames() - 1))
+    {
+    }
+
+    /**
+     * @brief Set the bytes of right records a hash table holds, a right partition up to this size is not split again.
+     * @param bytes The budget.
+     */
+    auto setMemoryBudget(storage_t bytes) -> void
+    {
+        memoryBudget = std::max<storage_t>(bytes, sizeof(R));
+    }
+
+    /**
+     * @brief Set the number of partitions an input is cut into, one chunk buffer each.
+     * @param partitions The fan-out, at least 2.
+     */
+    auto setFanOut(size_t partitions) -> void
+    {
+        fanOut = std::max<size_t>(2, partitions);
+    }
+
+    /**
+     * @brief Join two relations.
+     * @param leftStart Address of the first left record (inclusive).
+     * @param leftEnd Address one past the last left record (exclusive).
+     * @param rightStart Address of the first right record (inclusive).
+     * @param rightEnd Address one past the last right record (exclusive).
+     * @param output Address the joined records are written from, with room for all of them.
+     * @return The address one past the last joined record.
+     * @throws std::runtime_error if the space manager cannot hold the partitions.
+     */
+    auto join(address_id_t leftStart, address_id_t leftEnd, address_id_t rightStart, address_id_t rightEnd, address_id_t output) -> address_id_t
+    {
+        Chunks left{{leftStart, (leftEnd - leftStart) / sizeof(L)}}, right{{rightStart, (rightEnd - rightStart) / sizeof(R)}};
+        RunWriter<Out> writer(*buffer_manager, output);
+        joinPartitions(left, right, 0, writer);
+        return writer.finish();
+    }
+};
+
+#endif // _GRACE_HASH_JOIN_HPP_
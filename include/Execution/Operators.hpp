@@ -0,0 +1,815 @@
+#pragma once
+
+#ifndef _OPERATORS_HPP_
+    #define _OPERATORS_HPP_
+
+    #include <memory>
+    #include <vector>
+    #include <span>
+    #include <functional>
+    #include <algorithm>
+    #include <unordered_map>
+    #include <utility>
+
+    #include <Utilities/Utils.hpp>
+    #include <Utilities/Schema.hpp>
+    #include <Utilities/Predicate.hpp>
+    #include <Storage/BufferManager.hpp>
+    #include <Storage/RecordView.hpp>
+
+/**
+ * Pull based query operators exchanging batches of records.
+ * A consumer calls `open` once per run, then `next` until it returns false; each call hands over up to
+ * `EXECUTION_BATCH_ROWS` records, so the per call overhead is paid once per batch rather than once per tuple.
+ * Operators are chained by owning their inputs, and records only reach the disk when a pipeline is materialized.
+ */
+
+// Number of records an operator hands over per call
+inline constexpr size_t EXECUTION_BATCH_ROWS = 1024;
+
+/**
+ * Interface of every operator producing records of type `T`.
+ * @tparam T Type of the records produced.
+ */
+template <typename T>
+class Operator
+{
+    public:
+
+    using row_type = T;
+
+    virtual ~Operator() = default;
+
+    /**
+     * @brief Prepare to produce the records from the first one, also restarts an operator that already ran.
+     */
+    virtual auto open() -> void = 0;
+
+    /**
+     * @brief Produce the next batch.
+     * @param batch Replaced by up to `EXECUTION_BATCH_ROWS` records.
+     * @return false once every record was produced, the batch is then empty.
+     */
+    virtual auto next(std::vector<T> &batch) -> bool = 0;
+
+    /**
+     * @brief Release what the run holds, e.g. the hash table of a join.
+     */
+    virtual auto close() -> void {}
+};
+
+template <typename T>
+using OperatorPtr = std::unique_ptr<Operator<T>>;
+
+/**
+ * Base of the operators that can produce more records from one input batch than fit in an output batch.
+ * `produce` fills a pending buffer that `next` hands over one batch at a time.
+ * @tparam T Type of the records produced.
+ */
+template <typename T>
+class BufferedOperator : public Operator<T>
+{
+    private:
+
+    // produced records not handed over yet
+    std::vector<T> pending;
+
+    // first record of pending not handed over yet
+    size_t position = 0;
+
+    protected:
+
+    /**
+     * @brief Produce the next records.
+     * @param out Receives at least one record unless the input is exhausted.
+     * @return false once every record was produced.
+     */
+    virtual auto produce(std::vector<T> &out) -> bool = 0;
+
+    // Drop the records not handed over, for `open`
+    auto resetPending() -> void
+    {
+        pending.clear();
+        position = 0;
+    }
+
+    public:
+
+    auto next(std::vector<T> &batch) -> bool override
+    {
+        batch.clear();
+        if (position == pending.size())
+        {
+            resetPending();
+            if (!produce(pending) || pending.empty())
+            {
+                return false;
+            }
+        }
+        size_t count = std::min(EXECUTION_BATCH_ROWS, pending.size() - position);
+        batch.insert(batch.end(), pending.begin() + position, pending.begin() + position + count);
+        position += count;
+        return true;
+    }
+};
+
+/**
+ * Row at a time view of an operator's output, used by the joins.
+ * @tparam T Type of the records.
+ */
+template <typename T>
+class OperatorCursor
+{
+    private:
+
+    // operator read from
+    Operator<T> *input;
+
+    // current batch
+    std::vector<T> batch;
+
+    // current record in the batch
+    size_t position = 0;
+
+    public:
+
+    explicit OperatorCursor(Operator<T> &_input) : input(&_input) {}
+
+    // Open the input and move to its first record
+    auto open() -> void
+    {
+        input->open();
+        batch.clear();
+        position = 0;
+        input->next(batch);
+    }
+
+    auto valid() const -> bool
+    {
+        return position < batch.size();
+    }
+
+    auto get() const -> const T &
+    {
+        return batch[position];
+    }
+
+    auto advance() -> void
+    {
+        if (++position == batch.size())
+        {
+            position = 0;
+            input->next(batch);
+        }
+    }
+};
+
+/**
+ * Reads records stored back to back on the disk, in address order.
+ * @tparam T Type of the records.
+ */
+template <typename T>
+class Scan : public Operator<T>
+{
+    private:
+
+    // buffer manager holding the pages
+    BufferManager *buffer_manager;
+
+    // address of the first record
+    address_id_t start;
+
+    // address one past the last record
+    address_id_t end;
+
+    // address of the next record to produce
+    address_id_t current;
+
+    public:
+
+    Scan(BufferManager &buffer, address_id_t _start, address_id_t _end)
+        : buffer_manager(&buffer), start(_start), end(_end), current(_start) {}
+
+    auto open() -> void override
+    {
+        current = start;
+    }
+
+    auto next(std::vector<T> &batch) -> bool override
+    {
+        batch.clear();
+        address_id_t batchEnd = std::min<address_id_t>(end, current + EXECUTION_BATCH_ROWS * sizeof(T));
+        scanRecords<T>(*buffer_manager, current, batchEnd, [&batch](std::span<const T> records, address_id_t) {
+            batch.insert(batch.end(), records.begin(), records.end());
+        });
+        current += batch.size() * sizeof(T);
+        return !batch.empty();
+    }
+};
+
+/**
+ * Reads the records an index finds for a key range, in address order so pages are read once.
+ * @tparam T Type of the records.
+ * @tparam Index Index whose `rangeSearch(low, high)` returns (key, address) pairs, e.g. `BPlusTreeIndex`.
+ * @tparam Key Type of the index keys.
+ */
+template <typename T, typename Index, typename Key>
+class IndexScan : public Operator<T>
+{
+    private:
+
+    // buffer manager holding the pages
+    BufferManager *buffer_manager;
+
+    // index searched
+    Index *index;
+
+    // smallest key (inclusive)
+    Key low;
+
+    // largest key (inclusive)
+    Key high;
+
+    // addresses of the matching records
+    std::vector<address_id_t> addresses;
+
+    // next address to read
+    size_t position = 0;
+
+    public:
+
+    IndexScan(BufferManager &buffer, Index &_index, Key _low, Key _high)
+        : buffer_manager(&buffer), index(&_index), low(_low), high(_high) {}
+
+    auto open() -> void override
+    {
+        addresses.clear();
+        for (const auto &[key, address] : index->rangeSearch(low, high))
+        {
+            addresses.push_back(static_cast<address_id_t>(address));
+        }
+        std::sort(addresses.begin(), addresses.end());
+        position = 0;
+    }
+
+    auto next(std::vector<T> &batch) -> bool override
+    {
+        batch.clear();
+        for (; position < addresses.size() && batch.size() < EXECUTION_BATCH_ROWS; ++position)
+        {
+            batch.push_back(viewRecord<T>(*buffer_manager, addresses[position]).get());
+        }
+        return !batch.empty();
+    }
+
+    auto close() -> void override
+    {
+        addresses = {};
+    }
+};
+
+/**
+ * @brief Create an index scan, deducing the index and key types.
+ * @tparam T Type of the records.
+ * @param buffer BufferManager holding the records.
+ * @param index The index.
+ * @param low Smallest key (inclusive).
+ * @param high Largest key (inclusive).
+ * @return The operator.
+ */
+template <typename T, typename Index, typename Key>
+auto makeIndexScan(BufferManager &buffer, Index &index, Key low, Key high) -> OperatorPtr<T>
+{
+    return std::make_unique<IndexScan<T, Index, Key>>(buffer, index, low, high);
+}
+
+/**
+ * Keeps the records satisfying a predicate.
+ * @tparam T Type of the records.
+ */
+template <typename T>
+class Filter : public Operator<T>
+{
+    private:
+
+    // input records
+    OperatorPtr<T> input;
+
+    // true for the records kept
+    std::function<bool(const T &)> predicate;
+
+    public:
+
+    Filter(OperatorPtr<T> _input, std::function<bool(const T &)> _predicate)
+        : input(std::move(_input)), predicate(std::move(_predicate)) {}
+
+    auto open() -> void override
+    {
+        input->open();
+    }
+
+    auto next(std::vector<T> &batch) -> bool override
+    {
+        // input batches are filtered in place until one keeps a record
+        while (input->next(batch))
+        {
+            std::erase_if(batch, [this](const T &record) { return !predicate(record); });
+            if (!batch.empty())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto close() -> void override
+    {
+        input->close();
+    }
+};
+
+/**
+ * Keeps the records whose 32 bit integer field lies in [low, high], evaluated a batch at a time by `selectRange`.
+ * @tparam member Pointer to the field, e.g. `&Employee::salary`.
+ * @tparam T Type of the records.
+ */
+template <auto member, typename T = typename MemberTraits<decltype(member)>::record_type>
+class RangeFilter : public Operator<T>
+{
+    private:
+
+    // input records
+    OperatorPtr<T> input;
+
+    // smallest value kept (inclusive)
+    int32_t low;
+
+    // largest value kept (inclusive)
+    int32_t high;
+
+    // positions of the kept records in the current batch
+    std::vector<uint32_t> selection;
+
+    public:
+
+    RangeFilter(OperatorPtr<T> _input, int32_t _low, int32_t _high)
+        : input(std::move(_input)), low(_low), high(_high) {}
+
+    auto open() -> void override
+    {
+        input->open();
+    }
+
+    auto next(std::vector<T> &batch) -> bool override
+    {
+        while (input->next(batch))
+        {
+            selection.resize(batch.size());
+            size_t selected = selectRange<member>(std::span<const T>(batch), low, high, selection.data());
+
+            // positions ascend, so kept records are compacted in place
+            for (size_t i = 0; i < selected; ++i)
+            {
+                batch[i] = batch[selection[i]];
+            }
+            batch.resize(selected);
+            if (!batch.empty())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto close() -> void override
+    {
+        input->close();
+    }
+};
+
+/**
+ * Maps every record to a record of another type.
+ * @tparam In Type of the input records.
+ * @tparam Out Type of the output records.
+ */
+template <typename In, typename Out>
+class Project : public Operator<Out>
+{
+    private:
+
+    // input records
+    OperatorPtr<In> input;
+
+    // maps an input record to an output record
+    std::function<Out(const In &)> projection;
+
+    // current input batch
+    std::vector<In> inputBatch;
+
+    public:
+
+    Project(OperatorPtr<In> _input, std::function<Out(const In &)> _projection)
+        : input(std::move(_input)), projection(std::move(_projection)) {}
+
+    auto open() -> void override
+    {
+        input->open();
+    }
+
+    auto next(std::vector<Out> &batch) -> bool override
+    {
+        batch.clear();
+        if (!input->next(inputBatch))
+        {
+            return false;
+        }
+        batch.reserve(inputBatch.size());
+        std::transform(inputBatch.begin(), inputBatch.end(), std::back_inserter(batch), projection);
+        return true;
+    }
+
+    auto close() -> void override
+    {
+        input->close();
+        inputBatch = {};
+    }
+};
+
+/**
+ * Stops after a number of records.
+ * @tparam T Type of the records.
+ */
+template <typename T>
+class Limit : public Operator<T>
+{
+    private:
+
+    // input records
+    OperatorPtr<T> input;
+
+    // number of records to produce
+    size_t limit;
+
+    // number of records produced
+    size_t produced = 0;
+
+    public:
+
+    Limit(OperatorPtr<T> _input, size_t _limit) : input(std::move(_input)), limit(_limit) {}
+
+    auto open() -> void override
+    {
+        input->open();
+        produced = 0;
+    }
+
+    auto next(std::vector<T> &batch) -> bool override
+    {
+        batch.clear();
+        if (produced == limit || !input->next(batch))
+        {
+            return false;
+        }
+        batch.resize(std::min(batch.size(), limit - produced));
+        produced += batch.size();
+        return true;
+    }
+
+    auto close() -> void override
+    {
+        input->close();
+    }
+};
+
+/**
+ * Sorts its input in memory, stable, by the schema key unless told otherwise.
+ * @tparam T Type of the records.
+ */
+template <typename T>
+class Sort : public Operator<T>
+{
+    private:
+
+    // input records
+    OperatorPtr<T> input;
+
+    // strict weak order of the records
+    std::function<bool(const T &, const T &)> less;
+
+    // the sorted input
+    std::vector<T> records;
+
+    // next record to produce
+    size_t position = 0;
+
+    public:
+
+    Sort(OperatorPtr<T> _input, std::function<bool(const T &, const T &)> _less = KeyLess{})
+        : input(std::move(_input)), less(std::move(_less)) {}
+
+    auto open() -> void override
+    {
+        input->open();
+        records.clear();
+        std::vector<T> batch;
+        while (input->next(batch))
+        {
+            records.insert(records.end(), batch.begin(), batch.end());
+        }
+        std::stable_sort(records.begin(), records.end(), less);
+        position = 0;
+    }
+
+    auto next(std::vector<T> &batch) -> bool override
+    {
+        size_t count = std::min(EXECUTION_BATCH_ROWS, records.size() - position);
+        batch.assign(records.begin() + position, records.begin() + position + count);
+        position += count;
+        return count > 0;
+    }
+
+    auto close() -> void override
+    {
+        input->close();
+        records = {};
+    }
+};
+
+/**
+ * Equi-join on the schema keys that builds a hash table on the right input and probes it with the left one.
+ * Output follows the left input's order, then the right input's order among the matches of a record.
+ * @tparam L Type of the left (probe) records.
+ * @tparam R Type of the right (build) records.
+ * @tparam Out Type of the joined records, constructible from (L, R).
+ */
+template <typename L, typename R, typename Out>
+class HashJoin : public BufferedOperator<Out>
+{
+    private:
+
+    // probe input
+    OperatorPtr<L> left;
+
+    // build input
+    OperatorPtr<R> right;
+
+    // right records of each key
+    std::unordered_map<KeyType<R>, std::vector<R>> table;
+
+    // current probe batch
+    std::vector<L> probe;
+
+    protected:
+
+    auto produce(std::vector<Out> &out) -> bool override
+    {
+        while (out.empty())
+        {
+            if (!left->next(probe))
+            {
+                return false;
+            }
+            for (const L &record : probe)
+            {
+                auto it = table.find(keyOf(record));
+                if (it == table.end())
+                {
+                    continue;
+                }
+                for (const R &match : it->second)
+                {
+                    out.emplace_back(record, match);
+                }
+            }
+        }
+        return true;
+    }
+
+    public:
+
+    HashJoin(OperatorPtr<L> _left, OperatorPtr<R> _right) : left(std::move(_left)), right(std::move(_right)) {}
+
+    auto open() -> void override
+    {
+        this->resetPending();
+        table.clear();
+        right->open();
+        std::vector<R> batch;
+        while (right->next(batch))
+        {
+            for (const R &record : batch)
+            {
+                table[keyOf(record)].push_back(record);
+            }
+        }
+        right->close();
+        left->open();
+    }
+
+    auto close() -> void override
+    {
+        left->close();
+        table = {};
+    }
+};
+
+/**
+ * Equi-join on the schema keys of two inputs sorted by them.
+ * @tparam L Type of the left records.
+ * @tparam R Type of the right records.
+ * @tparam Out Type of the joined records, constructible from (L, R).
+ */
+template <typename L, typename R, typename Out>
+class MergeJoin : public BufferedOperator<Out>
+{
+    private:
+
+    // left input
+    OperatorPtr<L> left;
+
+    // right input
+    OperatorPtr<R> right;
+
+    // current records of both inputs
+    OperatorCursor<L> leftCursor;
+    OperatorCursor<R> rightCursor;
+
+    // right records sharing the current key
+    std::vector<R> group;
+
+    protected:
+
+    auto produce(std::vector<Out> &out) -> bool override
+    {
+        while (out.size() < EXECUTION_BATCH_ROWS && leftCursor.valid() && rightCursor.valid())
+        {
+            if (keyOf(leftCursor.get()) < keyOf(rightCursor.get()))
+            {
+                leftCursor.advance();
+                continue;
+            }
+            if (keyOf(rightCursor.get()) < keyOf(leftCursor.get()))
+            {
+                rightCursor.advance();
+                continue;
+            }
+
+            // every left record with the key is paired with the whole right group
+            auto key = keyOf(rightCursor.get());
+            group.clear();
+            for (; rightCursor.valid() && keyOf(rightCursor.get()) == key; rightCursor.advance())
+            {
+                group.push_back(rightCursor.get());
+            }
+            for (; leftCursor.valid() && keyOf(leftCursor.get()) == key; leftCursor.advance())
+            {
+                for (const R &match : group)
+                {
+                    out.emplace_back(leftCursor.get(), match);
+                }
+            }
+        }
+        return !out.empty();
+    }
+
+    public:
+
+    MergeJoin(OperatorPtr<L> _left, OperatorPtr<R> _right)
+        : left(std::move(_left)), right(std::move(_right)), leftCursor(*left), rightCursor(*right) {}
+
+    auto open() -> void override
+    {
+        this->resetPending();
+        leftCursor.open();
+        rightCursor.open();
+    }
+
+    auto close() -> void override
+    {
+        left->close();
+        right->close();
+        group = {};
+    }
+};
+
+/**
+ * Block nested loop join: the inner input is rescanned once per outer batch, pairs matching a predicate are kept.
+ * @tparam L Type of the outer records.
+ * @tparam R Type of the inner records.
+ * @tparam Out Type of the joined records, constructible from (L, R).
+ */
+template <typename L, typename R, typename Out>
+class NestedLoopJoin : public BufferedOperator<Out>
+{
+    private:
+
+    // outer input
+    OperatorPtr<L> outer;
+
+    // inner input, reopened for every outer batch
+    OperatorPtr<R> inner;
+
+    // true for the pairs joined
+    std::function<bool(const L &, const R &)> predicate;
+
+    // current outer batch
+    std::vector<L> outerBatch;
+
+    // current inner batch
+    std::vector<R> innerBatch;
+
+    // true while the inner input is being scanned for the current outer batch
+    bool scanningInner = false;
+
+    protected:
+
+    auto produce(std::vector<Out> &out) -> bool override
+    {
+        while (out.empty())
+        {
+            if (!scanningInner)
+            {
+                if (!outer->next(outerBatch))
+                {
+                    return false;
+                }
+                inner->open();
+                scanningInner = true;
+            }
+            if (!inner->next(innerBatch))
+            {
+                scanningInner = false;
+                continue;
+            }
+            for (const L &outerRecord : outerBatch)
+            {
+                for (const R &innerRecord : innerBatch)
+                {
+                    if (predicate(outerRecord, innerRecord))
+                    {
+                        out.emplace_back(outerRecord, innerRecord);
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    public:
+
+    NestedLoopJoin(OperatorPtr<L> _outer, OperatorPtr<R> _inner,
+                   std::function<bool(const L &, const R &)> _predicate = [](const L &l, const R &r) { return keyOf(l) == keyOf(r); })
+        : outer(std::move(_outer)), inner(std::move(_inner)), predicate(std::move(_predicate)) {}
+
+    auto open() -> void override
+    {
+        this->resetPending();
+        scanningInner = false;
+        outer->open();
+    }
+
+    auto close() -> void override
+    {
+        outer->close();
+        inner->close();
+    }
+};
+
+/**
+ * @brief Run an operator and visit its output a batch at a time.
+ * @tparam T Type of the records.
+ * @param op The root of the pipeline.
+ * @param visit Called with every batch, valid during the call.
+ */
+template <typename T, typename Visit>
+auto drain(Operator<T> &op, Visit &&visit) -> void
+{
+    std::vector<T> batch;
+    op.open();
+    while (op.next(batch))
+    {
+        visit(std::span<const T>(batch));
+    }
+    op.close();
+}
+
+/**
+ * @brief Run an operator and write its output back to back on the disk.
+ * @tparam T Type of the records.
+ * @param op The root of the pipeline.
+ * @param buffer BufferManager of the disk.
+ * @param start Address of the first record written.
+ * @return The address one past the last record written.
+ */
+template <typename T>
+auto materialize(Operator<T> &op, BufferManager &buffer, address_id_t start) -> address_id_t
+{
+    address_id_t end = start;
+    drain(op, [&](std::span<const T> records) {
+        bulkWrite(buffer, end, std::as_bytes(records));
+        end += records.size_bytes();
+    });
+    return end;
+}
+
+#endif // _OPERATORS_HPP_
@@ -0,0 +1,205 @@
+#pragma once
+
+#ifndef _PARALLEL_SCAN_HPP_
+    #define _PARALLEL_SCAN_HPP_
+
+    #include <deque>
+    #include <mutex>
+    #include <memory>
+    #include <vector>
+    #include <optional>
+    #include <algorithm>
+
+    #include <Utilities/Utils.hpp>
+    #include <Utilities/TaskScheduler.hpp>
+    #include <Storage/BufferManager.hpp>
+    #include <Storage/RecordView.hpp>
+    #include <Execution/Operators.hpp>
+
+/**
+ * Morsel driven parallel scans.
+ * The pages of a relation are cut into morsels of `MORSEL_PAGES` pages, a morsel holding the records that start in
+ * its pages. Each worker is dealt a contiguous share of the morsels, takes them from the front of its own queue and,
+ * once it runs dry, steals from the back of the others', so a slow worker never holds up the scan.
+ */
+
+// Number of pages in a morsel
+inline constexpr size_t MORSEL_PAGES = 16;
+
+// Per worker queues of morsel numbers
+class MorselQueue
+{
+    private:
+
+    // morsels left to each worker
+    std::vector<std::deque<size_t>> queues;
+
+    // guards each queue
+    std::unique_ptr<std::mutex[]> locks;
+
+    public:
+
+    MorselQueue(size_t numMorsels, unsigned numWorkers) : queues(numWorkers), locks(new std::mutex[numWorkers])
+    {
+        for (unsigned worker = 0; worker < numWorkers; ++worker)
+        {
+            for (size_t morsel = numMorsels * worker / numWorkers; morsel < numMorsels * (worker + 1) / numWorkers; ++morsel)
+            {
+                queues[worker].push_back(morsel);
+            }
+        }
+    }
+
+    /**
+     * @brief Take the next morsel of a worker, stealing one if its own queue is empty.
+     * @param worker The worker.
+     * @return The morsel, or std::nullopt once every queue is empty.
+     */
+    auto pop(unsigned worker) -> std::optional<size_t>
+    {
+        {
+            std::lock_guard<std::mutex> lock(locks[worker]);
+            if (!queues[worker].empty())
+            {
+                size_t morsel = queues[worker].front();
+                queues[worker].pop_front();
+                return morsel;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); ++i)
+        {
+            unsigned victim = (worker + i) % queues.size();
+            std::lock_guard<std::mutex> lock(locks[victim]);
+            if (!queues[victim].empty())
+            {
+                size_t morsel = queues[victim].back();
+                queues[victim].pop_back();
+                return morsel;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+/**
+ * @brief Get the number of morsels of a relation.
+ * @param blockSize Size of a page in bytes.
+ * @param start Address of the first record (inclusive).
+ * @param end Address one past the last record (exclusive).
+ * @param recordSize Size of a record in bytes.
+ * @return The number of morsels, 0 for an empty relation.
+ */
+inline auto countMorsels(storage_t blockSize, address_id_t start, address_id_t end, storage_t recordSize) -> size_t
+{
+    const address_id_t last = start + (end - start) / recordSize * recordSize;
+    return last == start ? 0 : ((last - 1) / blockSize - start / blockSize) / MORSEL_PAGES + 1;
+}
+
+/**
+ * @brief Run a function on every morsel of a relation with several threads.
+ * @param buffer BufferManager holding the pages, shared by the workers.
+ * @param start Address of the first record (inclusive).
+ * @param end Address one past the last record (exclusive).
+ * @param recordSize Size of a record in bytes.
+ * @param numThreads Number of workers, run as tasks of the shared `TaskScheduler` and capped so their pins leave half the frames free.
+ * @param work Called as `work(worker, morsel, morselStart, morselEnd)`, concurrently for different morsels.
+ * @return The number of morsels.
+ * @note The first exception thrown by a worker cancels the scan and is rethrown once every worker has stopped.
+ */
+template <typename Work>
+auto forEachMorsel(BufferManager &buffer, address_id_t start, address_id_t end, storage_t recordSize, unsigned numThreads, Work &&work) -> size_t
+{
+    const storage_t blockSize = buffer.getBlockSize();
+    const address_id_t last = start + (end - start) / recordSize * recordSize;
+    const page_id_t firstPage = start / blockSize;
+    const size_t numMorsels = countMorsels(blockSize, start, end, recordSize);
+    if (numMorsels == 0)
+    {
+        return 0;
+    }
+
+    // first record starting at or after the first page of a morsel
+    auto boundary = [&](size_t morsel) -> address_id_t {
+        address_id_t pageStart = static_cast<address_id_t>(firstPage + morsel * MORSEL_PAGES) * blockSize;
+        if (pageStart <= start)
+        {
+            return start;
+        }
+        return std::min(last, start + (pageStart - start + recordSize - 1) / recordSize * recordSize);
+    };
+
+    unsigned numWorkers = std::clamp<unsigned>(numThreads, 1, std::max(1u, buffer.getNumFrames() / 2));
+    numWorkers = std::min<size_t>(numWorkers, numMorsels);
+    MorselQueue morsels(numMorsels, numWorkers);
+
+    // every worker is a task of the shared scheduler, a failing worker cancels the others between morsels
+    TaskGroup group;
+    for (unsigned worker = 0; worker < numWorkers; ++worker)
+    {
+        group.run([&, worker]() {
+            while (!group.isCancelled())
+            {
+                auto morsel = morsels.pop(worker);
+                if (!morsel.has_value())
+                {
+                    break;
+                }
+                work(worker, morsel.value(), boundary(morsel.value()), boundary(morsel.value() + 1));
+            }
+        });
+    }
+    group.wait();
+    return numMorsels;
+}
+
+/**
+ * @brief Visits fixed size records in place, morsel by morsel, with several threads.
+ * @tparam T Type of the records.
+ * @param buffer BufferManager holding the pages, shared by the workers.
+ * @param start Address of the first record (inclusive).
+ * @param end Address one past the last record (exclusive).
+ * @param numThreads Number of workers.
+ * @param visit Called as `visit(worker, records, address)` like the visit of `scanRecords`, concurrently.
+ */
+template <typename T, typename Visit>
+auto parallelScan(BufferManager &buffer, address_id_t start, address_id_t end, unsigned numThreads, Visit &&visit) -> void
+{
+    forEachMorsel(buffer, start, end, sizeof(T), numThreads, [&](unsigned worker, size_t, address_id_t morselStart, address_id_t morselEnd) {
+        scanRecords<T>(buffer, morselStart, morselEnd, [&](std::span<const T> records, address_id_t address) {
+            visit(worker, records, address);
+        });
+    });
+}
+
+/**
+ * @brief Runs the same operator pipeline over every morsel with several threads.
+ * @tparam T Type of the records scanned.
+ * @tparam Out Type of the records the pipeline produces.
+ * @param buffer BufferManager holding the pages, shared by the workers.
+ * @param start Address of the first record (inclusive).
+ * @param end Address one past the last record (exclusive).
+ * @param numThreads Number of workers.
+ * @param makePipeline Builds a pipeline on top of the scan of one morsel, e.g. a `RangeFilter`; called concurrently.
+ * @return The pipelines' output, in address order of the morsels.
+ * @note Every morsel's output is collected by the worker that ran it, and only concatenated at the end.
+ */
+template <typename T, typename Out, typename MakePipeline>
+auto parallelPipeline(BufferManager &buffer, address_id_t start, address_id_t end, unsigned numThreads, MakePipeline &&makePipeline) -> std::vector<Out>
+{
+    std::vector<std::vector<Out>> outputs(countMorsels(buffer.getBlockSize(), start, end, sizeof(T)));
+    forEachMorsel(buffer, start, end, sizeof(T), numThreads, [&](unsigned, size_t morsel, address_id_t morselStart, address_id_t morselEnd) {
+        OperatorPtr<Out> pipeline = makePipeline(std::make_unique<Scan<T>>(buffer, morselStart, morselEnd));
+        drain(*pipeline, [&](std::span<const Out> batch) {
+            outputs[morsel].insert(outputs[morsel].end(), batch.begin(), batch.end());
+        });
+    });
+
+    std::vector<Out> result;
+    for (const auto &output : outputs)
+    {
+        result.insert(result.end(), output.begin(), output.end());
+    }
+    return result;
+}
+
+#endif // _PARALLEL_SCAN_HPP_
@@ -7,15 +7,111 @@
     #include <optional>
     #include <stack>
     #include <list>
+    #include <mutex>
+    #include <thread>
+    #include <atomic>
+    #include <unordered_set>
+    #include <span>
 
     #include <Utilities/Utils.hpp>
     #include <Storage/Disk.hpp>
+    #include <Storage/CompressedTier.hpp>
 
     #define LRU 0
     #define MRU 1
 
+class BufferManager;
+
+// Keeps a page pinned in the buffer while it is alive, giving direct access to the frame's data
+class PageGuard
+{
+    friend class BufferManager;
+
+    private:
+
+    // buffer manager the page is pinned in, nullptr once released
+    BufferManager *buffer_manager;
+
+    // frame holding the page
+    frame_id_t frame;
+
+    // data of the frame
+    std::byte *frameData;
+
+    // true if the frame's data was modified through this guard
+    bool dirty;
+
+    PageGuard ( BufferManager *_bm, frame_id_t _frame, std::byte *_frameData )
+        : buffer_manager( _bm ), frame( _frame ), frameData( _frameData ), dirty( false )
+    {
+    }
+
+    public:
+
+    PageGuard ( const PageGuard & ) = delete;
+    PageGuard &operator= ( const PageGuard & ) = delete;
+
+    PageGuard ( PageGuard &&other ) noexcept
+        : buffer_manager( other.buffer_manager ), frame( other.frame ), frameData( other.frameData ), dirty( other.dirty )
+    {
+        other.buffer_manager = nullptr;
+    }
+
+    PageGuard &operator= ( PageGuard &&other ) noexcept
+    {
+        if ( this != &other )
+        {
+            release();
+            buffer_manager = other.buffer_manager;
+            frame = other.frame;
+            frameData = other.frameData;
+            dirty = other.dirty;
+            other.buffer_manager = nullptr;
+        }
+        return *this;
+    }
+
+    ~PageGuard ( )
+    {
+        release();
+    }
+
+    /**
+     * @brief Get read access to the page.
+     * @returns Pointer to the first byte of the page.
+     */
+    auto data ( ) const -> const std::byte *
+    {
+        return frameData;
+    }
+
+    /**
+     * @brief Get write access to the page, the page is written back when it is evicted.
+     * @returns Pointer to the first byte of the page.
+     */
+    auto mutableData ( ) -> std::byte *
+    {
+        dirty = true;
+        return frameData;
+    }
+
+    /**
+     * @brief Count further accesses to the pinned page, e.g. one per record read in place after the first.
+     * @param accesses The number of accesses.
+     * @note Each access counts as a memory access and makes the page the most recently used, as a readAddress would.
+     */
+    auto touch ( size_t accesses = 1 ) -> void;
+
+    /**
+     * @brief Unpin the page before the guard is destroyed.
+     */
+    auto release ( ) -> void;
+};
+
 class BufferManager 
 {
+    friend class PageGuard;
+
     private:
 
     // Pointer to the disk object
@@ -54,6 +150,42 @@ class BufferManager
     // dirty bit for each frame
     std::vector< bool > isDirty;
 
+    // number of accesses to the page held by each frame since it was loaded
+    std::vector< unsigned long long > accessCount;
+
+    // sidecar file the hottest pages are saved to on shutdown, empty if warm-up is disabled
+    std::string warmupFile;
+
+    // number of pages to save in the sidecar file, 0 saves every resident page
+    size_t warmupCount;
+
+    // pages read ahead by the warm-up thread, moved into a frame on their first miss
+    std::unordered_map< page_id_t, std::vector< std::byte > > warmPages {};
+
+    // pages written back since warm-up started, their read ahead copy is stale
+    std::unordered_set< page_id_t > staleWarmPages {};
+
+    // guards warmPages and staleWarmPages
+    std::mutex warmMutex;
+
+    // background thread reloading the pages listed in the sidecar file
+    std::thread warmThread;
+
+    // asks the warm-up thread to stop early
+    std::atomic< bool > stopWarmup;
+
+    // number of blocks read by the warm-up thread
+    std::atomic< unsigned long long > numWarmReads;
+
+    // guards the page table, the frames' bookkeeping and the disk, so scans may share the pool across threads
+    mutable std::recursive_mutex poolMutex;
+
+    // compressed copies of evicted pages, checked on a miss before the disk
+    std::optional< CompressedTier > compressedTier;
+
+    // number of misses served by the compressed tier
+    unsigned long long numTierHits;
+
     /**
      * @brief Find a victim frame to replace using the specified replacement strategy.
      * @returns The frame ID of the victim frame, or std::nullopt if no victim frame is found.
@@ -75,18 +207,51 @@ class BufferManager
     auto getFrame ( page_id_t pageNumber ) -> std::optional< frame_id_t >;
 
     /**
-     * @brief Read data for a given page number.
-     * @param pageNumber The page number to get the data for.
-     * @returns The data for the page.
+     * @brief Get the frame holding a given page, loading the page if it is not in the buffer.
+     * @param pageNumber The page number to get the frame for.
+     * @returns The frame ID of the page.
+     * @note Throws if the page is out of range or every frame is pinned.
+     */
+    auto residentFrame ( page_id_t pageNumber ) -> frame_id_t;
+
+    /**
+     * @brief Drop one pin on a frame.
+     * @param frame The frame to unpin.
+     * @param dirty true if the pinned data was modified.
+     */
+    auto unpinFrame ( frame_id_t frame, bool dirty ) -> void;
+
+    /**
+     * @brief Count accesses to a resident frame and move it to the most recently used end of the busy list.
+     * @param frame The frame accessed.
+     * @param accesses The number of accesses.
+     */
+    auto touchFrame ( frame_id_t frame, size_t accesses ) -> void;
+
+    /**
+     * @brief Fetch a block for the pool, from the compressed tier or the warm-up read ahead copy when there is one.
+     * @param pageNumber The page number to fetch.
+     * @returns The data of the page.
+     */
+    auto fetchBlock ( page_id_t pageNumber ) -> std::vector< std::byte >;
+
+    /**
+     * @brief Write a frame back to the disk and invalidate any read ahead copy of its page.
+     * @param frame The frame to write back.
+     */
+    auto flushFrame ( frame_id_t frame ) -> void;
+
+    /**
+     * @brief Drop a page from the pool without writing it back.
+     * @param frame The frame holding the page, it must not be pinned.
      */
-    auto readPage ( page_id_t pageNumber ) -> std::vector< std::byte >;
+    auto dropFrame ( frame_id_t frame ) -> void;
 
     /**
-     * @brief Write data for a given page number.abort
-     * @param pageNumber The page number to update the data for.
-     * @param data The data to write for the page.
+     * @brief Body of the warm-up thread, reads the listed pages in block order.
+     * @param pages The pages to read ahead.
      */
-    auto writePage ( page_id_t pageNumber, const std::vector< std::byte > &data ) -> void;
+    auto warmupWorker ( std::vector< page_id_t > pages ) -> void;
 
     public:
 
@@ -109,7 +274,24 @@ class BufferManager
      * @param address The address to write to.
      * @param data The data to write to the address.
      */
-    auto writeAddress ( address_id_t address, const std::vector< std::byte > &data ) -> void;
+    auto writeAddress ( address_id_t address, std::span< const std::byte > data ) -> void;
+
+    /**
+     * @brief Write whole pages straight to the disk with one multi-block write, bypassing the pool.
+     * @param firstPage The first page number to write to.
+     * @param data The data to write, a whole number of pages.
+     * @note Copies of these pages held in the pool, the compressed tier or the warm-up read ahead are discarded.
+     *       Throws if one of the pages is pinned.
+     */
+    auto writePages ( page_id_t firstPage, std::span< const std::byte > data ) -> void;
+
+    /**
+     * @brief Pin a page in the buffer and get direct access to its frame.
+     * @param pageNumber The page number to pin.
+     * @returns A guard that keeps the page pinned until it is destroyed.
+     * @note A pinned page is never chosen as a victim, so its data pointer stays valid while the guard lives.
+     */
+    auto pinPage ( page_id_t pageNumber ) -> PageGuard;
 
     /**
      * @brief Get the number of disk IO till now from creation of disk.
@@ -138,6 +320,24 @@ class BufferManager
         return numFrames;
     }
 
+    /**
+     * @brief Get the size of a block (and frame) in bytes.
+     * @returns The block size.
+     */
+    auto getBlockSize ( ) const -> storage_t
+    {
+        return disk->blockSize;
+    }
+
+    /**
+     * @brief Get the number of blocks in the disk.
+     * @returns The block count.
+     */
+    auto getBlockCount ( ) const -> size_t
+    {
+        return disk->blockCount;
+    }
+
     /**
      * @brief Get the type of replacement strategy used.
      * @returns The type of replacement strategy used, LRU or MRU macro.
@@ -154,6 +354,50 @@ class BufferManager
      */
     auto clearCache( ) -> void;
 
+    /**
+     * @brief Save the IDs of the hottest resident pages to a sidecar file.
+     * @param fileName The sidecar file to write.
+     * @param count The number of pages to save, 0 saves every resident page.
+     * @note Pages are ranked by their access count, ties go to the most recently used page.
+     */
+    auto saveHotPages ( std::string fileName, size_t count = 0 ) -> void;
+
+    /**
+     * @brief Reload the pages listed in a sidecar file in the background and save the hottest pages back to it on shutdown.
+     * @param fileName The sidecar file to read and later write.
+     * @param count The number of pages to save on shutdown, 0 saves every resident page.
+     * @note Pages are read in block order by a separate thread and enter the pool on their first access.
+     *       A missing sidecar file only enables saving on shutdown.
+     */
+    auto enableWarmup ( std::string fileName, size_t count = 0 ) -> void;
+
+    /**
+     * @brief Get the number of blocks the warm-up thread has read so far.
+     * @returns The number of warm-up block reads.
+     * @note A block counts once its read ahead copy can serve a miss.
+     */
+    auto getNumWarmReads ( ) const -> unsigned long long
+    {
+        return numWarmReads;
+    }
+
+    /**
+     * @brief Keep compressed copies of evicted pages in memory and serve misses from them.
+     * @param capacity The number of compressed bytes the tier may hold.
+     * @note Dirty pages are still written to the disk on eviction, the tier only holds clean copies.
+     */
+    auto enableCompressedTier ( storage_t capacity ) -> void;
+
+    /**
+     * @brief Get the number of misses served by the compressed tier.
+     * @returns The number of compressed tier hits.
+     */
+    auto getNumTierHits ( ) const -> unsigned long long
+    {
+        std::lock_guard< std::recursive_mutex > lock( poolMutex );
+        return numTierHits;
+    }
+
     /**
      * @brief Get the statistics related to IO operations.
      * @returns A Stats object containing the number of IO operations, disk accesses, and cost of disk accesses.
@@ -161,6 +405,7 @@ class BufferManager
      */
     auto getStats ( ) const -> Stats
     {
+        std::lock_guard< std::recursive_mutex > lock( poolMutex );
         return { (long long) numIO, (long long) disk->numIO, (long long) disk->costIO };
     }
 
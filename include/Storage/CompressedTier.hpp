@@ -0,0 +1,103 @@
+#pragma once
+
+#ifndef _COMPRESSED_TIER_HPP_
+    #define _COMPRESSED_TIER_HPP_
+
+    #include <unordered_map>
+    #include <optional>
+    #include <vector>
+    #include <list>
+
+    #include <Utilities/Utils.hpp>
+
+/**
+ * @brief Compress a block with a byte oriented LZ77 codec.
+ * @param data The block to compress.
+ * @returns The compressed representation of the block.
+ */
+auto compressBlock ( const std::vector< std::byte > &data ) -> std::vector< std::byte >;
+
+/**
+ * @brief Decompress a block produced by compressBlock.
+ * @param data The compressed representation of the block.
+ * @param size The size of the original block.
+ * @returns The original block.
+ */
+auto decompressBlock ( const std::vector< std::byte > &data, storage_t size ) -> std::vector< std::byte >;
+
+class CompressedTier
+{
+    private:
+
+    // maximum number of compressed bytes held
+    storage_t capacity;
+
+    // number of compressed bytes currently held
+    storage_t usedBytes;
+
+    // size of an uncompressed page
+    storage_t pageSize;
+
+    // pages in the tier, recently inserted at the end
+    std::list< page_id_t > order {};
+
+    // Page ID -> compressed data and its position in the order list
+    std::unordered_map< page_id_t, std::pair< std::vector< std::byte >, std::list< page_id_t >::iterator > > pages {};
+
+    /**
+     * @brief Remove a page from the tier.
+     * @param it Iterator to the page to remove.
+     */
+    auto drop ( decltype( pages )::iterator it ) -> void;
+
+    public:
+
+    // Constructor
+    CompressedTier ( storage_t _capacity, storage_t _pageSize );
+
+    /**
+     * @brief Compress a page and keep it, evicting the oldest pages if the tier is full.
+     * @param pageNumber The page number of the data.
+     * @param data The uncompressed page data.
+     * @note Pages that do not compress to at most 3/4 of their size are not kept.
+     */
+    auto put ( page_id_t pageNumber, const std::vector< std::byte > &data ) -> void;
+
+    /**
+     * @brief Remove a page from the tier and return its uncompressed data.
+     * @param pageNumber The page number to look for.
+     * @returns The page data, or std::nullopt if the page is not in the tier.
+     */
+    auto take ( page_id_t pageNumber ) -> std::optional< std::vector< std::byte > >;
+
+    /**
+     * @brief Drop a page from the tier if it is present.
+     * @param pageNumber The page number to drop.
+     */
+    auto erase ( page_id_t pageNumber ) -> void;
+
+    /**
+     * @brief Drop every page in the tier.
+     */
+    auto clear ( ) -> void;
+
+    /**
+     * @brief Get the number of compressed bytes held.
+     * @returns The number of bytes used by the tier.
+     */
+    auto getUsedBytes ( ) const -> storage_t
+    {
+        return usedBytes;
+    }
+
+    /**
+     * @brief Get the number of pages held.
+     * @returns The number of pages in the tier.
+     */
+    auto getNumPages ( ) const -> size_t
+    {
+        return pages.size();
+    }
+};
+
+#endif // _COMPRESSED_TIER_HPP_
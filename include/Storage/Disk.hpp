@@ -5,6 +5,7 @@
 
     #include <vector>
     #include <fstream>
+    #include <span>
     
     #include <Utilities/Utils.hpp>
     
@@ -52,6 +53,13 @@ class Disk
      */
     auto writeBlock ( block_id_t blockNumber, const std::vector< std::byte > &data ) -> void;
 
+    /**
+     * @brief Write consecutive blocks in the disk with a single seek.
+     * @param firstBlock The first block number to write to.
+     * @param data The data to write, a whole number of blocks.
+     */
+    auto writeBlocks ( block_id_t firstBlock, std::span< const std::byte > data ) -> void;
+
     public:
 
     // Constructor
@@ -0,0 +1,198 @@
+#pragma once
+
+#ifndef _HEAP_FILE_HPP_
+    #define _HEAP_FILE_HPP_
+
+    #include <vector>
+    #include <optional>
+    #include <functional>
+    #include <span>
+    #include <cstdint>
+
+    #include <Utilities/Utils.hpp>
+    #include <Storage/BufferManager.hpp>
+    #include <Storage/SpaceManager.hpp>
+
+// Identifies a record by the page it lives on and its slot in that page
+struct RecordId
+{
+    // page number relative to the first data page of the file
+    page_id_t page;
+
+    // index of the record in the page's slot directory
+    uint32_t slot;
+
+    friend auto operator== ( const RecordId &lhs, const RecordId &rhs ) -> bool = default;
+
+    friend auto operator<=> ( const RecordId &lhs, const RecordId &rhs ) = default;
+};
+
+/**
+ * Heap file of variable length records stored in slotted pages.
+ * The first page of the extent holds the file header, every other page is laid out as
+ *      | page header | slot directory -> |   free space   | <- tuples |
+ * The slot directory grows from the front of the page and tuples grow from the back,
+ * so a tuple never spans two pages and keeps its record ID when it moves within its page.
+ */
+class HeapFile
+{
+    private:
+
+    struct FileHeader
+    {
+        // identifies an initialised heap file
+        uint64_t magic;
+
+        // number of data pages in use
+        uint64_t numPages;
+    };
+
+    struct PageHeader
+    {
+        // number of entries in the slot directory, including empty ones
+        uint32_t slotCount;
+
+        // offset of the first tuple byte, tuples occupy [dataStart, pageSize)
+        uint32_t dataStart;
+    };
+
+    struct Slot
+    {
+        // offset of the tuple in the page
+        uint32_t offset;
+
+        // length of the tuple in bytes, 0 if the slot is empty
+        uint32_t length;
+    };
+
+    // buffer manager used to read and write pages
+    BufferManager *buffer_manager;
+
+    // extent holding the file, header page first
+    Extent extent;
+
+    // size of a page in bytes
+    storage_t pageSize;
+
+    // number of data pages in use
+    page_id_t numPages;
+
+    // free bytes of each data page as far as known, pages not touched in this session count as full
+    std::vector< storage_t > freeSpace;
+
+    /**
+     * @brief Get the disk address of a data page.
+     * @param page The page number relative to the first data page.
+     * @returns The address of the page.
+     */
+    auto pageAddress ( page_id_t page ) const -> address_id_t
+    {
+        return extent.start + ( page + 1 ) * pageSize;
+    }
+
+    /**
+     * @brief Read a data page.
+     * @param page The page number to read.
+     * @returns The page data.
+     */
+    auto loadPage ( page_id_t page ) -> std::vector< std::byte >;
+
+    /**
+     * @brief Write a data page and remember its free space.
+     * @param page The page number to write.
+     * @param data The page data.
+     */
+    auto savePage ( page_id_t page, const std::vector< std::byte > &data ) -> void;
+
+    /**
+     * @brief Write the file header.
+     */
+    auto saveHeader ( ) -> void;
+
+    /**
+     * @brief Get the number of free bytes in a page, counting the space of deleted tuples.
+     * @param data The page data.
+     * @returns The number of bytes available to a new tuple and its slot.
+     */
+    auto pageFreeSpace ( const std::vector< std::byte > &data ) const -> storage_t;
+
+    /**
+     * @brief Move all tuples of a page to its end so the free space is contiguous.
+     * @param data The page data, compacted in place.
+     */
+    auto compact ( std::vector< std::byte > &data ) const -> void;
+
+    /**
+     * @brief Place a tuple in a page that is known to have room for it.
+     * @param data The page data.
+     * @param slot The slot to use for the tuple.
+     * @param tuple The tuple bytes.
+     */
+    auto placeTuple ( std::vector< std::byte > &data, uint32_t slot, std::span< const std::byte > tuple ) const -> void;
+
+    public:
+
+    /**
+     * @brief Constructor
+     * @param _bm Buffer manager used to read and write pages.
+     * @param _extent Extent holding the file.
+     * @param create true to initialise an empty file in a newly allocated extent, false to open the file stored in it.
+     * @note Throws if the extent is too small, or if it holds no heap file when opening.
+     */
+    HeapFile ( BufferManager *_bm, Extent _extent, bool create );
+
+    /**
+     * @brief Insert a tuple.
+     * @param tuple The tuple bytes.
+     * @returns The record ID of the tuple, or std::nullopt if it does not fit in a page or the extent is full.
+     */
+    auto insert ( std::span< const std::byte > tuple ) -> std::optional< RecordId >;
+
+    /**
+     * @brief Read a tuple.
+     * @param rid The record ID of the tuple.
+     * @returns The tuple bytes, or std::nullopt if there is no tuple with this record ID.
+     */
+    auto read ( RecordId rid ) -> std::optional< std::vector< std::byte > >;
+
+    /**
+     * @brief Replace a tuple in place, keeping its record ID.
+     * @param rid The record ID of the tuple.
+     * @param tuple The new tuple bytes.
+     * @returns true if the tuple was replaced, false if it does not exist or the page has no room for the new size.
+     */
+    auto update ( RecordId rid, std::span< const std::byte > tuple ) -> bool;
+
+    /**
+     * @brief Delete a tuple, its space is reclaimed by later inserts into the page.
+     * @param rid The record ID of the tuple.
+     * @returns true if the tuple was deleted, false if it does not exist.
+     */
+    auto remove ( RecordId rid ) -> bool;
+
+    /**
+     * @brief Visit every tuple in page and slot order.
+     * @param visit Called with the record ID and bytes of each tuple.
+     */
+    auto scan ( const std::function< void ( RecordId, std::span< const std::byte > ) > &visit ) -> void;
+
+    /**
+     * @brief Get the number of data pages in use.
+     * @returns The number of data pages.
+     */
+    auto getNumPages ( ) const -> page_id_t
+    {
+        return numPages;
+    }
+
+    /**
+     * @brief Get the largest tuple a page can hold.
+     * @returns The maximum tuple size in bytes.
+     */
+    auto getMaxTupleSize ( ) const -> storage_t
+    {
+        return pageSize - sizeof( PageHeader ) - sizeof( Slot );
+    }
+};
+
+#endif // _HEAP_FILE_HPP_
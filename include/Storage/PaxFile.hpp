@@ -0,0 +1,184 @@
+#pragma once
+
+#ifndef _PAX_FILE_HPP_
+    #define _PAX_FILE_HPP_
+
+    #include <vector>
+    #include <optional>
+    #include <functional>
+    #include <span>
+    #include <cstdint>
+
+    #include <Utilities/Utils.hpp>
+    #include <Utilities/Schema.hpp>
+    #include <Storage/BufferManager.hpp>
+    #include <Storage/SpaceManager.hpp>
+    #include <Storage/HeapFile.hpp>
+
+// Location and width of one attribute of a record
+struct PaxColumn
+{
+    // offset of the attribute in the record struct
+    storage_t offset;
+
+    // width of the attribute in bytes
+    storage_t width;
+};
+
+/**
+ * File of fixed size records stored in PAX pages.
+ * The first page of the extent holds the file header, every other page is laid out as
+ *      | page header | all values of column 0 | all values of column 1 | ... |
+ * so a scan that needs one attribute only touches that attribute's bytes,
+ * while a whole tuple can still be rebuilt from its record ID.
+ */
+template<typename T>
+class PaxFile
+{
+    private:
+
+    struct FileHeader
+    {
+        // identifies an initialised PAX file
+        uint64_t magic;
+
+        // number of records in the file
+        uint64_t numRecords;
+    };
+
+    struct PageHeader
+    {
+        // number of records in the page
+        uint32_t count;
+
+        // keeps the first column 8 byte aligned
+        uint32_t padding;
+    };
+
+    // buffer manager used to read and write pages
+    BufferManager *buffer_manager;
+
+    // extent holding the file, header page first
+    Extent extent;
+
+    // size of a page in bytes
+    storage_t pageSize;
+
+    // columns of T in declaration order
+    std::vector< PaxColumn > columns;
+
+    // number of records a page can hold
+    size_t capacity;
+
+    // number of records in the file
+    uint64_t numRecords;
+
+    /**
+     * @brief Get the disk page number of a data page.
+     * @param page The page number relative to the first data page.
+     * @returns The page number in the disk.
+     */
+    auto diskPage ( page_id_t page ) const -> page_id_t
+    {
+        return extent.start / pageSize + page + 1;
+    }
+
+    /**
+     * @brief Get the offset of a column's values in a page.
+     * @param column The column index.
+     * @returns The offset of the first value of the column.
+     */
+    auto columnOffset ( size_t column ) const -> storage_t;
+
+    /**
+     * @brief Write the file header.
+     */
+    auto saveHeader ( ) -> void;
+
+    public:
+
+    /**
+     * @brief Constructor
+     * @param _bm Buffer manager used to read and write pages.
+     * @param _extent Extent holding the file.
+     * @param create true to initialise an empty file in a newly allocated extent, false to open the file stored in it.
+     * @note Throws if the extent is too small, or if it holds no PAX file when opening.
+     */
+    PaxFile ( BufferManager *_bm, Extent _extent, bool create );
+
+    // Destructor, writes the file header
+    ~PaxFile ( );
+
+    /**
+     * @brief Get the columns of T in declaration order, as described by its schema.
+     * @returns The offset and width of each column.
+     */
+    static auto getColumns ( ) -> std::vector< PaxColumn >;
+
+    /**
+     * @brief Get the extent size needed for a number of records.
+     * @param numRecords The number of records to store.
+     * @param pageSize The size of a page.
+     * @returns The number of bytes needed, header page included.
+     */
+    static auto requiredSize ( size_t numRecords, storage_t pageSize ) -> storage_t;
+
+    /**
+     * @brief Append a record at the end of the file.
+     * @param record The record to append.
+     * @returns The record ID of the record, or std::nullopt if the extent is full.
+     */
+    auto append ( const T &record ) -> std::optional< RecordId >;
+
+    /**
+     * @brief Rebuild a record from its columns.
+     * @param rid The record ID of the record.
+     * @returns The record, or std::nullopt if there is no record with this record ID.
+     */
+    auto get ( RecordId rid ) -> std::optional< T >;
+
+    /**
+     * @brief Visit the values of one column, one page at a time, directly in pinned frames.
+     * @param column The column index, in declaration order of the fields of T.
+     * @param visit Called with the page number, the first value of the column and the number of values in the page.
+     */
+    auto scanColumn ( size_t column, const std::function< void ( page_id_t, const std::byte *, size_t ) > &visit ) -> void;
+
+    /**
+     * @brief Visit the values of one column as typed values.
+     * @tparam V Type of the column's values.
+     * @param column The column index, in declaration order of the fields of T.
+     * @param visit Called with the page number and the values of the column in the page.
+     */
+    template < typename V >
+    auto scanColumnAs ( size_t column, const std::function< void ( page_id_t, std::span< const V > ) > &visit ) -> void
+    {
+        if ( columns[column].width != sizeof( V ) || columnOffset( column ) % alignof( V ) != 0 )
+        {
+            throw std::invalid_argument( "Column cannot be viewed as this type" );
+        }
+        scanColumn( column, [&visit]( page_id_t page, const std::byte *values, size_t count ) {
+            visit( page, std::span< const V >( reinterpret_cast< const V * >( values ), count ) );
+        });
+    }
+
+    /**
+     * @brief Get the number of records in the file.
+     * @returns The number of records.
+     */
+    auto getNumRecords ( ) const -> uint64_t
+    {
+        return numRecords;
+    }
+
+    /**
+     * @brief Get the number of records a page holds.
+     * @returns The page capacity in records.
+     */
+    auto getCapacity ( ) const -> size_t
+    {
+        return capacity;
+    }
+};
+
+#endif // _PAX_FILE_HPP_
@@ -0,0 +1,200 @@
+#pragma once
+
+#ifndef _RECORD_VIEW_HPP_
+    #define _RECORD_VIEW_HPP_
+
+    #include <optional>
+    #include <span>
+    #include <cstring>
+    #include <type_traits>
+
+    #include <Utilities/Utils.hpp>
+    #include <Storage/BufferManager.hpp>
+
+/**
+ * @brief View a record as raw bytes, e.g. to write it with BufferManager::writeAddress without a copy.
+ * @tparam T Type of the record.
+ * @param record The record to view.
+ * @return The bytes of the record.
+ */
+template <typename T>
+auto recordBytes(const T &record) -> std::span<const std::byte>
+{
+    static_assert(std::is_trivially_copyable_v<T>, "records must be trivially copyable");
+    return std::as_bytes(std::span<const T, 1>(&record, 1));
+}
+
+/**
+ * @brief Tells whether the record at an address can be viewed in place in its frame.
+ * @tparam T Type of the record.
+ * @param address The address of the record.
+ * @param blockSize The size of a block.
+ * @return true if the record is suitably aligned and does not straddle a page.
+ */
+template <typename T>
+auto isViewable(address_id_t address, storage_t blockSize) -> bool
+{
+    auto offset = address % blockSize;
+    return offset + sizeof(T) <= blockSize && offset % alignof(T) == 0;
+}
+
+/**
+ * @brief Visits fixed size records stored back to back, one page worth at a time, directly in pinned frames.
+ * @tparam T Type of the records (e.g., `Employee`, `Company`).
+ * @param buffer BufferManager holding the pages.
+ * @param start Address of the first record (inclusive).
+ * @param end Address one past the last record (exclusive).
+ * @param visit Called with the records of each page and the address of the first of them.
+ * @note The span is only valid during the call. Records that straddle a page are copied and visited on their own.
+ *       Every record counts as one memory access, as if it was read with `readAddress`.
+ */
+template <typename T, typename Visit>
+auto scanRecords(BufferManager &buffer, address_id_t start, address_id_t end, Visit &&visit) -> void
+{
+    static_assert(std::is_trivially_copyable_v<T>, "records must be trivially copyable");
+    const storage_t blockSize = buffer.getBlockSize();
+    address_id_t address = start;
+    while (address + sizeof(T) <= end)
+    {
+        if (!isViewable<T>(address, blockSize))
+        {
+            T record;
+            auto data = buffer.readAddress(address, sizeof(T));
+            std::memcpy(&record, data.data(), sizeof(T));
+            visit(std::span<const T>(&record, 1), address);
+            address += sizeof(T);
+            continue;
+        }
+        auto page = buffer.pinPage(address / blockSize);
+        size_t count = std::min((blockSize - address % blockSize) / sizeof(T), (end - address) / sizeof(T));
+        // every record is still one memory access, the pin counted the first
+        page.touch(count - 1);
+        visit(std::span<const T>(reinterpret_cast<const T *>(page.data() + address % blockSize), count), address);
+        address += count * sizeof(T);
+    }
+}
+
+/**
+ * Forward cursor over fixed size records stored back to back.
+ * The page of the current record stays pinned and the record is read in place,
+ * only records that straddle a page are copied. Moving to a record counts as one memory access and makes its page the
+ * most recently used, as reading it with `readAddress` would.
+ */
+template <typename T>
+class RecordCursor
+{
+    static_assert(std::is_trivially_copyable_v<T>, "records must be trivially copyable");
+
+    private:
+
+    // buffer manager holding the pages
+    BufferManager *buffer_manager;
+
+    // address of the current record
+    address_id_t current;
+
+    // address one past the last record
+    address_id_t end;
+
+    // pin on the page of the current record, empty when the record was copied
+    std::optional<PageGuard> page;
+
+    // records of the pinned page from the current one onward
+    const T *records;
+
+    // number of records left in the pinned page, including the current one
+    size_t remaining;
+
+    // copy of a record that straddles a page
+    T copy;
+
+    /**
+     * @brief Make the record at the current address available.
+     */
+    auto load() -> void
+    {
+        page.reset();
+        remaining = 0;
+        if (!valid())
+        {
+            return;
+        }
+        const storage_t blockSize = buffer_manager->getBlockSize();
+        if (!isViewable<T>(current, blockSize))
+        {
+            auto data = buffer_manager->readAddress(current, sizeof(T));
+            std::memcpy(&copy, data.data(), sizeof(T));
+            return;
+        }
+        page.emplace(buffer_manager->pinPage(current / blockSize));
+        records = reinterpret_cast<const T *>(page->data() + current % blockSize);
+        remaining = std::min((blockSize - current % blockSize) / sizeof(T), (end - current) / sizeof(T));
+    }
+
+    public:
+
+    // Constructor, positions the cursor on the record at start
+    RecordCursor(BufferManager &buffer, address_id_t start, address_id_t _end)
+        : buffer_manager(&buffer), current(start), end(_end), records(nullptr), remaining(0)
+    {
+        load();
+    }
+
+    /**
+     * @brief Tells whether the cursor is on a record.
+     * @return false once the cursor has moved past the last record.
+     */
+    auto valid() const -> bool
+    {
+        return current + sizeof(T) <= end;
+    }
+
+    /**
+     * @brief Get the current record.
+     * @return Reference to the record, valid until the cursor moves.
+     */
+    auto get() const -> const T &
+    {
+        return page.has_value() ? *records : copy;
+    }
+
+    /**
+     * @brief Get the address of the current record.
+     * @return The address of the record.
+     */
+    auto address() const -> address_id_t
+    {
+        return current;
+    }
+
+    /**
+     * @brief Move to the next record, unpinning the page once all of its records are passed.
+     */
+    auto advance() -> void
+    {
+        current += sizeof(T);
+        if (remaining > 1)
+        {
+            ++records;
+            --remaining;
+            page->touch();
+            return;
+        }
+        load();
+    }
+};
+
+/**
+ * @brief View a single record in place.
+ * @tparam T Type of the record.
+ * @param buffer BufferManager holding the page.
+ * @param address The address of the record.
+ * @return A cursor positioned on the record, keeping its page pinned while it lives.
+ */
+template <typename T>
+auto viewRecord(BufferManager &buffer, address_id_t address) -> RecordCursor<T>
+{
+    return RecordCursor<T>(buffer, address, address + sizeof(T));
+}
+
+#endif // _RECORD_VIEW_HPP_
@@ -0,0 +1,155 @@
+#pragma once
+
+#ifndef _SPACE_MANAGER_HPP_
+    #define _SPACE_MANAGER_HPP_
+
+    #include <vector>
+    #include <optional>
+
+    #include <Utilities/Utils.hpp>
+    #include <Storage/BufferManager.hpp>
+
+// A contiguous run of blocks handed out by the space manager
+struct Extent
+{
+    // address of the first byte of the extent, always block aligned
+    address_id_t start;
+
+    // size of the extent in bytes, always a multiple of the block size
+    storage_t size;
+
+    // address one past the last byte of the extent
+    auto end ( ) const -> address_id_t
+    {
+        return start + size;
+    }
+};
+
+class SpaceManager
+{
+    private:
+
+    // buffer manager the allocation map is read and written through
+    BufferManager *buffer_manager;
+
+    // size of a block in bytes
+    storage_t blockSize;
+
+    // number of blocks in the disk
+    size_t blockCount;
+
+    // number of blocks at the end of the disk holding the allocation map
+    size_t metaBlocks;
+
+    // allocation bit for each block, true if the block is in use
+    std::vector< bool > used;
+
+    // true if the in memory map differs from the one on disk
+    bool dirty;
+
+    /**
+     * @brief Get the address the allocation map is stored at.
+     * @returns The address of the first metadata block.
+     */
+    auto metaAddress ( ) const -> address_id_t
+    {
+        return ( blockCount - metaBlocks ) * blockSize;
+    }
+
+    /**
+     * @brief Mark a run of blocks as used or free.
+     * @param first The first block of the run.
+     * @param count The number of blocks in the run.
+     * @param value true to mark the blocks as used, false to mark them free.
+     */
+    auto mark ( block_id_t first, size_t count, bool value ) -> void;
+
+    public:
+
+    // Constructor, loads the allocation map from the disk or formats it if there is none
+    SpaceManager ( BufferManager *_bm );
+
+    // Destructor, writes the allocation map back to the disk
+    ~SpaceManager ( );
+
+    /**
+     * @brief Allocate the lowest addressed free extent of at least the given size.
+     * @param size The number of bytes needed, rounded up to whole blocks.
+     * @returns The allocated extent, or std::nullopt if no free run is large enough.
+     */
+    auto allocate ( storage_t size ) -> std::optional< Extent >;
+
+    /**
+     * @brief Allocate the largest free extent.
+     * @returns The allocated extent, or std::nullopt if the disk is full.
+     * @note Meant for structures whose final size is unknown, shrink the extent once they are built.
+     */
+    auto allocateLargest ( ) -> std::optional< Extent >;
+
+    /**
+     * @brief Give the tail of an extent back to the free space.
+     * @param extent The extent to shrink, updated in place.
+     * @param size The number of bytes to keep, rounded up to whole blocks.
+     */
+    auto shrink ( Extent &extent, storage_t size ) -> void;
+
+    /**
+     * @brief Give an extent back to the free space.
+     * @param extent The extent to release.
+     */
+    auto release ( const Extent &extent ) -> void;
+
+    /**
+     * @brief Mark every block except the allocation map itself as free.
+     */
+    auto format ( ) -> void;
+
+    /**
+     * @brief Write the allocation map to the disk if it changed.
+     */
+    auto sync ( ) -> void;
+
+    /**
+     * @brief Get the number of free blocks.
+     * @returns The number of blocks not in use.
+     */
+    auto getFreeBlocks ( ) const -> size_t;
+};
+
+// Releases an extent back to its space manager when it goes out of scope, so an exception never leaks it
+class ExtentGuard
+{
+    private:
+
+    // space manager the extent came from
+    SpaceManager *space_manager;
+
+    // the guarded extent
+    Extent extent;
+
+    public:
+
+    ExtentGuard ( SpaceManager &space, Extent _extent )
+        : space_manager( &space ), extent( _extent )
+    {
+    }
+
+    ExtentGuard ( const ExtentGuard & ) = delete;
+    ExtentGuard &operator= ( const ExtentGuard & ) = delete;
+
+    ~ExtentGuard ( )
+    {
+        space_manager->release( extent );
+    }
+
+    /**
+     * @brief Get the guarded extent.
+     * @returns The extent.
+     */
+    auto get ( ) const -> const Extent &
+    {
+        return extent;
+    }
+};
+
+#endif // _SPACE_MANAGER_HPP_
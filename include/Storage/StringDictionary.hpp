@@ -0,0 +1,126 @@
+#pragma once
+
+#ifndef _STRING_DICTIONARY_HPP_
+    #define _STRING_DICTIONARY_HPP_
+
+    #include <vector>
+    #include <string>
+    #include <string_view>
+    #include <optional>
+    #include <unordered_map>
+    #include <cstdint>
+
+    #include <Utilities/Utils.hpp>
+    #include <Storage/BufferManager.hpp>
+    #include <Storage/SpaceManager.hpp>
+
+/**
+ * Dictionary of the distinct strings of a table, stored in an extent.
+ * The first page of the extent holds the header, the entries follow back to back as
+ *      | length (1 byte) | characters | length | characters | ...
+ * An entry's code is its position in the dictionary, so codes never change once assigned.
+ */
+class StringDictionary
+{
+    private:
+
+    struct Header
+    {
+        // identifies an initialised dictionary
+        uint64_t magic;
+
+        // number of entries
+        uint64_t count;
+
+        // size of the entries in bytes
+        uint64_t bytes;
+    };
+
+    // buffer manager used to read and write pages
+    BufferManager *buffer_manager;
+
+    // extent holding the dictionary, header page first
+    Extent extent;
+
+    // size of a page in bytes
+    storage_t pageSize;
+
+    // entries in code order
+    std::vector< std::string > values;
+
+    // code of each entry
+    std::unordered_map< std::string, uint32_t > codes;
+
+    // size of the entries in bytes
+    storage_t bytes;
+
+    // size of the entries already written to the extent
+    storage_t savedBytes;
+
+    // number of entries already written to the extent
+    size_t savedCount;
+
+    public:
+
+    /**
+     * @brief Constructor
+     * @param _bm Buffer manager used to read and write pages.
+     * @param _extent Extent holding the dictionary.
+     * @param create true to initialise an empty dictionary in a newly allocated extent, false to open the one stored in it.
+     * @note Throws if the extent is too small, or if it holds no valid dictionary when opening.
+     */
+    StringDictionary ( BufferManager *_bm, Extent _extent, bool create );
+
+    // Destructor, writes new entries
+    ~StringDictionary ( );
+
+    StringDictionary ( const StringDictionary & ) = delete;
+    StringDictionary &operator= ( const StringDictionary & ) = delete;
+
+    /**
+     * @brief Get the code of a string, adding it to the dictionary if it is new.
+     * @param value The string, at most 255 bytes.
+     * @returns The code of the string.
+     * @note Throws if the extent cannot hold the new entry.
+     */
+    auto encode ( std::string_view value ) -> uint32_t;
+
+    /**
+     * @brief Get the code of a string without adding it, e.g. to turn an equality predicate into a code comparison.
+     * @param value The string.
+     * @returns The code of the string, or std::nullopt if no record holds it.
+     */
+    auto find ( std::string_view value ) const -> std::optional< uint32_t >;
+
+    /**
+     * @brief Get the string of a code.
+     * @param code The code.
+     * @returns The string, valid as long as the dictionary.
+     */
+    auto decode ( uint32_t code ) const -> std::string_view;
+
+    /**
+     * @brief Write the entries added since the last save and the header.
+     */
+    auto save ( ) -> void;
+
+    /**
+     * @brief Get the number of entries.
+     * @returns The number of distinct strings.
+     */
+    auto size ( ) const -> size_t
+    {
+        return values.size();
+    }
+
+    /**
+     * @brief Get the size of the stored entries.
+     * @returns The number of bytes the entries use in the extent, header page excluded.
+     */
+    auto getBytes ( ) const -> storage_t
+    {
+        return bytes;
+    }
+};
+
+#endif // _STRING_DICTIONARY_HPP_
@@ -0,0 +1,281 @@
+#pragma once
+
+	#ifndef _COLUMNAR_FILE_HPP_
+	#define _COLUMNAR_FILE_HPP_
+
+	#include <span>
+	#include <string>
+	#include <vector>
+	#include <cstdint>
+	#include <unordered_map>
+
+	#include <Utilities/Utils.hpp>
+	#include <Utilities/Schema.hpp>
+	#include <Storage/BufferManager.hpp>
+	#include <Storage/RecordView.hpp>
+
+/**
+ * Binary columnar result files.
+ * Rows are grouped in blocks of `COLUMNAR_BLOCK_ROWS`, and each block stores every column as its own chunk:
+ *      | block 0: column 0 chunk | column 1 chunk | ... | block 1: ... | dictionaries | footer | footer offset | magic |
+ * Integer columns are delta encoded as zigzag varints, string columns as codes into a sorted per-column dictionary.
+ * The footer describes the columns, the dictionaries and every chunk with its min/max value, and is made of
+ * fixed size 8 byte aligned structs so it can be used in place from a memory mapping.
+ */
+
+// Number of rows in a block of a columnar file
+inline constexpr size_t COLUMNAR_BLOCK_ROWS = 4096;
+
+// Identifies a columnar file, found at the start of the footer and in the last 8 bytes
+inline constexpr uint64_t COLUMNAR_MAGIC = 0x434F4C5245535531ULL;
+
+// Start of the footer
+struct ColumnarFooter
+{
+	// COLUMNAR_MAGIC
+	uint64_t magic;
+
+	// number of rows in the file
+	uint64_t numRows;
+
+	// size of a decoded record in bytes
+	uint64_t recordSize;
+
+	// number of columns, a ColumnarColumn follows the footer for each
+	uint32_t numColumns;
+
+	// number of blocks, a ColumnarChunk per column follows the columns for each
+	uint32_t numBlocks;
+};
+
+// Description of one column
+struct ColumnarColumn
+{
+	// field name, NUL terminated
+	char name[32];
+
+	// FieldKind of the column
+	uint32_t kind;
+
+	// width of the field in the record
+	uint32_t width;
+
+	// offset of the field in the record
+	uint64_t offset;
+
+	// offset of the dictionary in the file, string columns only
+	uint64_t dictOffset;
+
+	// number of dictionary entries, string columns only
+	uint32_t dictCount;
+
+	// width of a dictionary code in bytes, string columns only
+	uint32_t codeWidth;
+};
+
+// Location and statistics of the values of one column in one block
+struct ColumnarChunk
+{
+	// offset of the chunk in the file
+	uint64_t offset;
+
+	// size of the chunk in bytes
+	uint64_t size;
+
+	// smallest value, the smallest dictionary code for strings
+	int64_t min;
+
+	// largest value, the largest dictionary code for strings
+	int64_t max;
+};
+
+/**
+ * Writes records to a columnar file.
+ * Records are kept in memory until `finish`, since dictionaries are only sorted once every string is known.
+ */
+class ColumnarWriter
+{
+	private:
+
+	// output file name
+	std::string fileName;
+
+	// layout of a record
+	std::vector<FieldInfo> fields;
+
+	// size of a record in bytes
+	storage_t recordSize;
+
+	// number of rows appended
+	uint64_t numRows;
+
+	// values of each column in row order, strings hold their index in dictionaries[column]
+	std::vector<std::vector<int64_t>> values;
+
+	// distinct strings of each column in first seen order
+	std::vector<std::vector<std::string>> dictionaries;
+
+	// index of each distinct string in dictionaries[column]
+	std::vector<std::unordered_map<std::string, int64_t>> dictionaryIndex;
+
+	// true once the file is written
+	bool finished;
+
+	public:
+
+	/**
+	 * @brief Constructor
+	 * @param _fileName Output file name.
+	 * @param _fields Layout of a record, as returned by `fieldInfos`.
+	 * @param _recordSize Size of a record in bytes.
+	 */
+	ColumnarWriter(std::string _fileName, std::span<const FieldInfo> _fields, storage_t _recordSize);
+
+	// Destructor, writes the file if `finish` was not called
+	~ColumnarWriter();
+
+	/**
+	 * @brief Append a record.
+	 * @param record The bytes of the record.
+	 */
+	auto append(const std::byte *record) -> void;
+
+	/**
+	 * @brief Encode the appended records and write the file.
+	 */
+	auto finish() -> void;
+};
+
+/**
+ * Reads a columnar file through a memory mapping.
+ */
+class ColumnarFile
+{
+	private:
+
+	// mapped file
+	const std::byte *data;
+
+	// size of the mapped file
+	size_t size;
+
+	// footer in the mapping
+	const ColumnarFooter *footer;
+
+	// columns in the mapping
+	const ColumnarColumn *columns;
+
+	// chunks in the mapping, block major
+	const ColumnarChunk *chunks;
+
+	public:
+
+	/**
+	 * @brief Constructor, maps the file and checks its footer, the chunk locations and the dictionary offsets.
+	 * @param fileName The columnar file to open.
+	 */
+	ColumnarFile(const std::string &fileName);
+
+	// Destructor, unmaps the file
+	~ColumnarFile();
+
+	ColumnarFile(const ColumnarFile &) = delete;
+	ColumnarFile &operator=(const ColumnarFile &) = delete;
+
+	/**
+	 * @brief Get the number of rows in the file.
+	 * @return The number of rows.
+	 */
+	auto getNumRows() const -> uint64_t
+	{
+		return footer->numRows;
+	}
+
+	/**
+	 * @brief Get the number of blocks in the file.
+	 * @return The number of blocks.
+	 */
+	auto getNumBlocks() const -> uint32_t
+	{
+		return footer->numBlocks;
+	}
+
+	/**
+	 * @brief Get the columns of the file.
+	 * @return The column descriptions.
+	 */
+	auto getColumns() const -> std::span<const ColumnarColumn>
+	{
+		return {columns, footer->numColumns};
+	}
+
+	/**
+	 * @brief Get the location and min/max statistics of a column in a block.
+	 * @param block The block number.
+	 * @param column The column index.
+	 * @return The chunk description.
+	 */
+	auto getChunk(uint32_t block, uint32_t column) const -> const ColumnarChunk &
+	{
+		return chunks[static_cast<size_t>(block) * footer->numColumns + column];
+	}
+
+	/**
+	 * @brief Decode one block into records.
+	 * @param block The block number.
+	 * @param out Buffer of at least `COLUMNAR_BLOCK_ROWS` records, filled with the records of the block.
+	 * @return The number of records in the block.
+	 */
+	auto decodeBlock(uint32_t block, std::byte *out) const -> size_t;
+
+	/**
+	 * @brief Decode every record and write them to the disk, whole pages bypass the buffer pool.
+	 * @param buffer BufferManager of the disk.
+	 * @param start Address to write the first record to.
+	 * @param fields Layout the records must have, the file's columns must match it.
+	 * @return The address one past the last record written.
+	 */
+	auto load(BufferManager &buffer, address_id_t start, std::span<const FieldInfo> fields) const -> address_id_t;
+
+	/**
+	 * @brief Decode every record of type `T` and write them to the disk.
+	 * @tparam T Type of the records, described by a `Schema` specialization.
+	 * @param buffer BufferManager of the disk.
+	 * @param start Address to write the first record to.
+	 * @return The address one past the last record written.
+	 */
+	template <typename T>
+	auto load(BufferManager &buffer, address_id_t start) const -> address_id_t
+	{
+		if (footer->recordSize != sizeof(T))
+		{
+			throw std::runtime_error("Columnar file holds another record type");
+		}
+		static constexpr auto fields = fieldInfos<T>();
+		return load(buffer, start, fields);
+	}
+};
+
+/**
+ * @brief Writes records from the disk to a columnar file.
+ * @tparam T Type of the records, described by a `Schema` specialization.
+ * @param buffer BufferManager handling disk reads.
+ * @param start Starting address to read from (inclusive).
+ * @param end Ending address to read until (exclusive).
+ * @param fileName Output file name/path.
+ */
+template <typename T>
+auto storeColumnar(BufferManager &buffer, address_id_t start, address_id_t end, std::string fileName) -> void
+{
+	static constexpr auto fields = fieldInfos<T>();
+	ColumnarWriter writer(fileName, fields, sizeof(T));
+	scanRecords<T>(buffer, start, end, [&writer](std::span<const T> records, address_id_t) {
+		for (const T &record : records)
+		{
+			writer.append(reinterpret_cast<const std::byte *>(&record));
+		}
+	});
+	writer.finish();
+}
+
+	#endif // _COLUMNAR_FILE_HPP_
@@ -0,0 +1,60 @@
+#pragma once
+
+	#ifndef _CSV_CONVERTER_HPP_
+	#define _CSV_CONVERTER_HPP_
+
+	#include <span>
+	#include <string>
+	#include <vector>
+	#include <limits>
+	#include <thread>
+
+	#include <Utilities/Utils.hpp>
+	#include <Utilities/Schema.hpp>
+
+// Column mapping entry for a CSV column that is not stored in the record
+inline constexpr size_t SKIP_COLUMN = std::numeric_limits<size_t>::max();
+
+/**
+ * @brief Finds the first occurrence of a byte, 16 or 32 bytes at a time when SIMD is available.
+ * @param begin First byte to search.
+ * @param end One past the last byte to search.
+ * @param value The byte to find.
+ * @return Pointer to the first occurrence, or `end` if there is none.
+ */
+auto findByte(const char *begin, const char *end, char value) -> const char *;
+
+/**
+ * @brief Converts a delimited text file to a binary file of fixed size records, using several threads.
+ * @note The input is memory mapped and split into chunks on line boundaries, every chunk is parsed by a task of the
+ *       shared `TaskScheduler` straight into the memory mapped output. The first line is a header and is skipped, so are empty lines.
+ *       Leading and trailing blanks and quotes are trimmed from each value, and strings longer than their field are truncated.
+ * @param csvFile Path of the text file.
+ * @param binFile Path of the binary file to write.
+ * @param delim The field delimiter.
+ * @param fields Layout of the record, as returned by `fieldInfos`.
+ * @param recordSize Size of a record in bytes.
+ * @param columns Field index of each CSV column in `fields`, or `SKIP_COLUMN`.
+ * @param numThreads Number of chunks to parse in parallel.
+ * @return The number of records written.
+ */
+auto convertCsv(const std::string &csvFile, const std::string &binFile, char delim, std::span<const FieldInfo> fields, storage_t recordSize, const std::vector<size_t> &columns, unsigned numThreads) -> size_t;
+
+/**
+ * @brief Converts a delimited text file to a binary file of records of type `T`.
+ * @tparam T Type of the records, described by a `Schema` specialization.
+ * @param csvFile Path of the text file.
+ * @param binFile Path of the binary file to write.
+ * @param delim The field delimiter.
+ * @param columns Field index of each CSV column in the schema of `T`, or `SKIP_COLUMN`.
+ * @param numThreads Number of chunks to parse in parallel, defaults to the number of hardware threads.
+ * @return The number of records written.
+ */
+template <typename T>
+auto convertCsv(const std::string &csvFile, const std::string &binFile, char delim, const std::vector<size_t> &columns, unsigned numThreads = std::thread::hardware_concurrency()) -> size_t
+{
+	static constexpr auto fields = fieldInfos<T>();
+	return convertCsv(csvFile, binFile, delim, fields, sizeof(T), columns, numThreads);
+}
+
+	#endif // _CSV_CONVERTER_HPP_
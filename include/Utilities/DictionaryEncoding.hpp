@@ -0,0 +1,116 @@
+#pragma once
+
+	#ifndef _DICTIONARY_ENCODING_HPP_
+	#define _DICTIONARY_ENCODING_HPP_
+
+	#include <cstring>
+	#include <string_view>
+	#include <utility>
+
+	#include <Utilities/Utils.hpp>
+	#include <Utilities/Schema.hpp>
+	#include <Storage/BufferManager.hpp>
+	#include <Storage/RecordView.hpp>
+	#include <Storage/StringDictionary.hpp>
+
+/**
+ * Dictionary encoded storage.
+ * A record type T with string fields has an encoded form `EncodedType<T>` with the same fields in the same order,
+ * where every string field is replaced by a 4 byte code into the table's `StringDictionary`.
+ * Encoded records are several times smaller, and equal strings have equal codes, so equality predicates
+ * and joins on string columns can compare codes.
+ */
+
+// Converts one field between a record and its encoded form
+template <typename F, typename G, bool Encode>
+auto convertField(const typename F::record_type &record, typename G::record_type &out, auto &dictionary) -> void
+{
+	static_assert(F::name == G::name, "encoded record fields must match the record fields");
+	if constexpr (F::kind == FieldKind::STRING && Encode)
+	{
+		const auto &value = F::get(record);
+		G::get(out) = dictionary.encode(std::string_view(value.data(), strnlen(value.data(), value.size())));
+	}
+	else if constexpr (G::kind == FieldKind::STRING && !Encode)
+	{
+		auto value = dictionary.decode(F::get(record));
+		auto &field = G::get(out);
+		std::copy_n(value.begin(), std::min(value.size(), field.size() - 1), field.begin());
+	}
+	else
+	{
+		G::get(out) = F::get(record);
+	}
+}
+
+template <typename T, typename E, size_t... I>
+auto encodeFields(const T &record, E &out, StringDictionary &dictionary, std::index_sequence<I...>) -> void
+{
+	(convertField<FieldAt<T, I>, FieldAt<E, I>, true>(record, out, dictionary), ...);
+}
+
+template <typename E, typename T, size_t... I>
+auto decodeFields(const E &record, T &out, const StringDictionary &dictionary, std::index_sequence<I...>) -> void
+{
+	(convertField<FieldAt<E, I>, FieldAt<T, I>, false>(record, out, dictionary), ...);
+}
+
+/**
+ * @brief Encode the string fields of a record, adding new strings to the dictionary.
+ * @tparam T Type of the record.
+ * @param record The record.
+ * @param dictionary The table's dictionary.
+ * @return The encoded record.
+ */
+template <typename T>
+auto encodeStrings(const T &record, StringDictionary &dictionary) -> EncodedType<T>
+{
+	static_assert(fieldCount<T> == fieldCount<EncodedType<T>>, "encoded record fields must match the record fields");
+	EncodedType<T> out{};
+	encodeFields(record, out, dictionary, std::make_index_sequence<fieldCount<T>>{});
+	return out;
+}
+
+/**
+ * @brief Rebuild a record from its encoded form.
+ * @tparam T Type of the record.
+ * @param record The encoded record.
+ * @param dictionary The table's dictionary.
+ * @return The record, strings NUL padded.
+ */
+template <typename T>
+auto decodeStrings(const EncodedType<T> &record, const StringDictionary &dictionary) -> T
+{
+	T out{};
+	decodeFields(record, out, dictionary, std::make_index_sequence<fieldCount<T>>{});
+	return out;
+}
+
+/**
+ * @brief Encode a stored relation into its dictionary encoded form.
+ * @tparam T Type of the records.
+ * @param buffer BufferManager handling disk reads and writes.
+ * @param dictionary The table's dictionary.
+ * @param start Starting address of the relation (inclusive).
+ * @param end Ending address of the relation (exclusive).
+ * @param outStart Address to write the encoded records to.
+ * @return The address one past the last encoded record.
+ */
+template <typename T>
+auto encodeRelation(BufferManager &buffer, StringDictionary &dictionary, address_id_t start, address_id_t end, address_id_t outStart) -> address_id_t
+{
+	std::vector<EncodedType<T>> encoded;
+	address_id_t outEnd = outStart;
+	scanRecords<T>(buffer, start, end, [&](std::span<const T> records, address_id_t) {
+		encoded.clear();
+		for (const T &record : records)
+		{
+			encoded.push_back(encodeStrings(record, dictionary));
+		}
+		buffer.writeAddress(outEnd, std::as_bytes(std::span(encoded)));
+		outEnd += encoded.size() * sizeof(EncodedType<T>);
+	});
+	return outEnd;
+}
+
+	#endif // _DICTIONARY_ENCODING_HPP_
@@ -0,0 +1,57 @@
+#pragma once
+
+	#ifndef _KEY_SORT_HPP_
+	#define _KEY_SORT_HPP_
+
+	#include <span>
+	#include <vector>
+	#include <cstdint>
+	#include <algorithm>
+
+/**
+ * Key/pointer sorting of fixed size records.
+ * Instead of moving whole records through every comparison and swap, the sort works on a compact array of 16 byte
+ * (key prefix, index) pairs and the records are only touched once more, when they are gathered in sorted order.
+ * Prefixes come from `SortKey::prefix`; pairs whose prefix is the whole key, e.g. of integer keys, are sorted in
+ * linear time by an LSD radix sort.
+ */
+
+// Normalized key prefix of a record and its index in the records being sorted
+struct KeyPointer
+{
+	uint64_t prefix;
+	uint32_t index;
+};
+
+// Bits of the prefix sorted by one radix pass
+inline constexpr size_t RADIX_BITS = 8;
+
+// Number of buckets of a radix pass
+inline constexpr size_t RADIX_BUCKETS = size_t{1} << RADIX_BITS;
+
+/**
+ * @brief Sort key/pointer pairs by prefix with an LSD radix sort, equal prefixes keep their order.
+ * @note One read of the pairs builds the histograms of every digit, digits where all pairs agree are skipped, and
+ *       every pass scatters through a cache line sized write combining buffer per bucket.
+ * @param entries The pairs, sorted in place.
+ * @param scratch Holds the pairs between passes, resized to entries.size().
+ */
+auto radixSortKeyPointers(std::vector<KeyPointer> &entries, std::vector<KeyPointer> &scratch) -> void;
+
+/**
+ * @brief Copy records in the order of sorted key/pointer pairs.
+ * @tparam T Type of the records.
+ * @param entries The sorted pairs.
+ * @param records The records they point into.
+ * @param output Gets records[entries[i].index] at position i, must hold entries.size() records.
+ */
+template <typename T>
+auto gatherRecords(const std::vector<KeyPointer> &entries, std::span<const T> records, std::span<T> output) -> void
+{
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		output[i] = records[entries[i].index];
+	}
+}
+
+	#endif // _KEY_SORT_HPP_
@@ -0,0 +1,155 @@
+#pragma once
+
+	#ifndef _LOSER_TREE_HPP_
+	#define _LOSER_TREE_HPP_
+
+	#include <vector>
+	#include <cstddef>
+	#include <functional>
+
+/**
+ * Tournament tree of losers for k-way merging.
+ * Leaves are the inputs' current keys, every inner node keeps the input that lost the match played there and the
+ * overall winner is kept apart. Replacing the winner's key replays only the matches on its path to the root, about
+ * log2(k) comparisons with no sifting. Exhausted inputs lose every match, and equal keys are won by the input with
+ * the smaller index, so a merge of runs given in input order is stable.
+ * @tparam Key Type of the keys.
+ * @tparam Less Strict weak order of the keys.
+ */
+template <typename Key, typename Less = std::less<Key>>
+class LoserTree
+{
+	private:
+
+	// number of inputs
+	size_t numInputs;
+
+	// loser of the match at each inner node, node 1 is the root and the children of node i are 2i and 2i + 1
+	std::vector<size_t> losers;
+
+	// input currently winning the tournament
+	size_t winnerInput;
+
+	// current key of each input
+	std::vector<Key> keys;
+
+	// true for the inputs that ran out
+	std::vector<bool> exhausted;
+
+	// order of the keys
+	Less less;
+
+	// Tells whether input a beats input b
+	auto beats(size_t a, size_t b) const -> bool
+	{
+		if (exhausted[a] || exhausted[b])
+		{
+			return !exhausted[a] && (exhausted[b] || a < b);
+		}
+		if (less(keys[a], keys[b]))
+		{
+			return true;
+		}
+		return !less(keys[b], keys[a]) && a < b;
+	}
+
+	// Winner of the subtree at a node, recording the losers below it
+	auto build(size_t node) -> size_t
+	{
+		if (node >= numInputs)
+		{
+			return node - numInputs;
+		}
+		size_t left = build(2 * node), right = build(2 * node + 1);
+		if (beats(left, right))
+		{
+			losers[node] = right;
+			return left;
+		}
+		losers[node] = left;
+		return right;
+	}
+
+	// Replay the matches from an input's leaf to the root
+	auto replay(size_t input) -> void
+	{
+		size_t winner = input;
+		for (size_t node = (input + numInputs) / 2; node > 0; node /= 2)
+		{
+			if (beats(losers[node], winner))
+			{
+				std::swap(losers[node], winner);
+			}
+		}
+		winnerInput = winner;
+	}
+
+	public:
+
+	/**
+	 * @brief Constructor, plays the initial tournament.
+	 * @param initialKeys First key of each input.
+	 * @param initialExhausted true for the inputs that are empty.
+	 * @param _less Order of the keys.
+	 */
+	LoserTree(std::vector<Key> initialKeys, std::vector<bool> initialExhausted, Less _less = Less())
+		: numInputs(initialKeys.size()), losers(initialKeys.size()), winnerInput(0), keys(std::move(initialKeys)), exhausted(std::move(initialExhausted)), less(std::move(_less))
+	{
+		if (numInputs == 1)
+		{
+			winnerInput = 0;
+		}
+		else if (numInputs > 1)
+		{
+			winnerInput = build(1);
+		}
+	}
+
+	/**
+	 * @brief Tells whether every input ran out.
+	 * @return true once nothing is left to merge.
+	 */
+	auto empty() const -> bool
+	{
+		return numInputs == 0 || exhausted[winnerInput];
+	}
+
+	/**
+	 * @brief Get the input holding the smallest key.
+	 * @return The index of the input.
+	 */
+	auto winner() const -> size_t
+	{
+		return winnerInput;
+	}
+
+	/**
+	 * @brief Get the smallest key.
+	 * @return The key of the winning input.
+	 */
+	auto winnerKey() const -> const Key &
+	{
+		return keys[winnerInput];
+	}
+
+	/**
+	 * @brief Give the winning input its next key.
+	 * @param key The key.
+	 */
+	auto replaceWinner(Key key) -> void
+	{
+		keys[winnerInput] = std::move(key);
+		replay(winnerInput);
+	}
+
+	/**
+	 * @brief Mark the winning input as exhausted.
+	 */
+	auto exhaustWinner() -> void
+	{
+		exhausted[winnerInput] = true;
+		replay(winnerInput);
+	}
+};
+
+	#endif // _LOSER_TREE_HPP_
@@ -0,0 +1,97 @@
+#pragma once
+
+	#ifndef _PREDICATE_HPP_
+	#define _PREDICATE_HPP_
+
+	#include <span>
+	#include <cstdint>
+	#include <cstddef>
+	#include <type_traits>
+
+	#include <Utilities/Schema.hpp>
+
+/**
+ * Batch filter kernels producing selection vectors.
+ * A kernel compares a 32 bit integer column against constants and writes the position of every passing value, in
+ * order, to a selection vector. Values are read either from a column vector (stride 4) or from a field of records
+ * stored back to back (stride = record size). The widest kernel the CPU supports (AVX2, SSE2 or scalar) is picked
+ * at runtime, and every kernel is branch free on the values.
+ */
+
+// Comparison of a column against a constant
+enum class CompareOp
+{
+	EQUAL,
+	LESS,
+	LESS_EQUAL,
+	GREATER,
+	GREATER_EQUAL
+};
+
+/**
+ * @brief Selects the values lying in [low, high].
+ * @param values Address of the first value.
+ * @param count Number of values.
+ * @param stride Distance between two values in bytes, a multiple of 4.
+ * @param low Smallest passing value (inclusive).
+ * @param high Largest passing value (inclusive).
+ * @param selection Receives the position of each passing value, room for `count` entries.
+ * @return The number of passing values.
+ */
+auto selectRange(const std::byte *values, size_t count, size_t stride, int32_t low, int32_t high, uint32_t *selection) -> size_t;
+
+/**
+ * @brief Same as `selectRange`, one value at a time, regardless of the CPU.
+ */
+auto selectRangeScalar(const std::byte *values, size_t count, size_t stride, int32_t low, int32_t high, uint32_t *selection) -> size_t;
+
+/**
+ * @brief Selects the values satisfying `value op constant`.
+ * @param values Address of the first value.
+ * @param count Number of values.
+ * @param stride Distance between two values in bytes, a multiple of 4.
+ * @param op The comparison.
+ * @param constant The constant compared against.
+ * @param selection Receives the position of each passing value, room for `count` entries.
+ * @return The number of passing values.
+ */
+auto selectCompare(const std::byte *values, size_t count, size_t stride, CompareOp op, int32_t constant, uint32_t *selection) -> size_t;
+
+/**
+ * @brief Get the kernel picked for this CPU.
+ * @return "avx2", "sse2" or "scalar".
+ */
+auto predicateKernel() -> const char *;
+
+/**
+ * @brief Selects the values of a column vector lying in [low, high].
+ * @param column The values.
+ * @param low Smallest passing value (inclusive).
+ * @param high Largest passing value (inclusive).
+ * @param selection Receives the position of each passing value, room for `column.size()` entries.
+ * @return The number of passing values.
+ */
+inline auto selectRange(std::span<const int32_t> column, int32_t low, int32_t high, uint32_t *selection) -> size_t
+{
+	return selectRange(reinterpret_cast<const std::byte *>(column.data()), column.size(), sizeof(int32_t), low, high, selection);
+}
+
+/**
+ * @brief Selects the records whose field lies in [low, high], reading the field in place.
+ * @tparam member Pointer to a 32 bit integer field described by the record's `Schema`, e.g. `&Employee::salary`.
+ * @param records The records, e.g. a page as visited by `scanRecords`.
+ * @param low Smallest passing value (inclusive).
+ * @param high Largest passing value (inclusive).
+ * @param selection Receives the position of each passing record, room for `records.size()` entries.
+ * @return The number of passing records.
+ */
+template <auto member, typename T>
+auto selectRange(std::span<const T> records, int32_t low, int32_t high, uint32_t *selection) -> size_t
+{
+	static constexpr auto field = fieldInfos<T>()[fieldIndex<member>()];
+	static_assert(field.kind == FieldKind::INTEGER && field.width == sizeof(int32_t), "kernels compare 32 bit integer fields");
+	static_assert(sizeof(T) % sizeof(int32_t) == 0, "records must keep their integer fields aligned");
+	return selectRange(reinterpret_cast<const std::byte *>(records.data()) + field.offset, records.size(), sizeof(T), low, high, selection);
+}
+
+	#endif // _PREDICATE_HPP_
@@ -0,0 +1,485 @@
+#pragma once
+
+	#ifndef _SCHEMA_HPP_
+	#define _SCHEMA_HPP_
+
+	#include <tuple>
+	#include <array>
+	#include <cstddef>
+	#include <type_traits>
+	#include <string_view>
+	#include <cstring>
+	#include <fstream>
+	#include <iostream>
+	#include <stdexcept>
+	#include <charconv>
+	#include <future>
+	#include <deque>
+
+	#include <Utilities/Utils.hpp>
+	#include <Utilities/TaskScheduler.hpp>
+	#include <Storage/BufferManager.hpp>
+	#include <Storage/RecordView.hpp>
+
+/**
+ * Compile time schema descriptors.
+ * Every record type gets a Schema specialization listing its fields in declaration order
+ * and the field it is sorted and joined on. Operators are written against the schema,
+ * so each record type gets its own instantiation with field access resolved at compile time.
+ */
+
+// Splits a pointer to member into the record and value type
+template <typename M>
+struct MemberTraits;
+
+template <typename R, typename V>
+struct MemberTraits<V R::*>
+{
+	using record_type = R;
+	using value_type = V;
+};
+
+// String literal usable as a template argument, holds a field name
+template <size_t N>
+struct FieldName
+{
+	char value[N];
+
+	constexpr FieldName(const char (&name)[N])
+	{
+		std::copy_n(name, N, value);
+	}
+};
+
+// Kind of value a field holds
+enum class FieldKind
+{
+	INTEGER,
+	STRING
+};
+
+// Tells whether a type is a fixed size char array holding a NUL terminated string
+template <typename V>
+struct IsCharArray : std::false_type {};
+
+template <size_t N>
+struct IsCharArray<std::array<char, N>> : std::true_type {};
+
+/**
+ * Describes one field of a record.
+ * @tparam Member Pointer to the member.
+ * @tparam Offset Offset of the member in the record, from offsetof.
+ * @tparam Name Name of the field.
+ */
+template <auto Member, size_t Offset, FieldName Name>
+struct Field
+{
+	using record_type = typename MemberTraits<decltype(Member)>::record_type;
+	using value_type = typename MemberTraits<decltype(Member)>::value_type;
+
+	static_assert(std::is_integral_v<value_type> || IsCharArray<value_type>::value, "fields must be integers or char arrays");
+
+	static constexpr auto member = Member;
+	static constexpr size_t offset = Offset;
+	static constexpr size_t width = sizeof(value_type);
+	static constexpr std::string_view name{Name.value};
+	static constexpr FieldKind kind = std::is_integral_v<value_type> ? FieldKind::INTEGER : FieldKind::STRING;
+
+	static constexpr auto get(const record_type &record) -> const value_type &
+	{
+		return record.*Member;
+	}
+
+	static constexpr auto get(record_type &record) -> value_type &
+	{
+		return record.*Member;
+	}
+};
+
+// Declares a field of a record type
+#define FIELD(Type, member) Field<&Type::member, offsetof(Type, member), #member>
+
+// Runtime description of a field, for code that walks fields in a loop
+struct FieldInfo
+{
+	std::string_view name;
+	FieldKind kind;
+	size_t offset;
+	size_t width;
+};
+
+/**
+ * @brief Reads an integer field of a record.
+ * @param field The bytes of the field.
+ * @param width The width of the field, 1, 2, 4 or 8 bytes.
+ * @return The value of the field.
+ */
+inline auto readInteger(const std::byte *field, storage_t width) -> int64_t
+{
+	switch (width)
+	{
+		case 1: { int8_t value; std::memcpy(&value, field, 1); return value; }
+		case 2: { int16_t value; std::memcpy(&value, field, 2); return value; }
+		case 4: { int32_t value; std::memcpy(&value, field, 4); return value; }
+		case 8: { int64_t value; std::memcpy(&value, field, 8); return value; }
+	}
+	throw std::invalid_argument("Integer fields are 1, 2, 4 or 8 bytes wide");
+}
+
+template <typename T>
+struct Schema;
+
+template <>
+struct Schema<Employee>
+{
+	using Fields = std::tuple<FIELD(Employee, id), FIELD(Employee, company_id), FIELD(Employee, salary), FIELD(Employee, fname), FIELD(Employee, lname)>;
+	using Key = FIELD(Employee, company_id);
+};
+
+template <>
+struct Schema<Company>
+{
+	using Fields = std::tuple<FIELD(Company, id), FIELD(Company, name), FIELD(Company, slogan)>;
+	using Key = FIELD(Company, id);
+};
+
+template <>
+struct Schema<JoinEmployeeCompany>
+{
+	using Fields = std::tuple<FIELD(JoinEmployeeCompany, employee_id), FIELD(JoinEmployeeCompany, company_id), FIELD(JoinEmployeeCompany, salary), FIELD(JoinEmployeeCompany, fname), FIELD(JoinEmployeeCompany, lname), FIELD(JoinEmployeeCompany, name), FIELD(JoinEmployeeCompany, slogan)>;
+	using Key = FIELD(JoinEmployeeCompany, company_id);
+};
+
+template <>
+struct Schema<EncodedEmployee>
+{
+	using Fields = std::tuple<FIELD(EncodedEmployee, id), FIELD(EncodedEmployee, company_id), FIELD(EncodedEmployee, salary), FIELD(EncodedEmployee, fname), FIELD(EncodedEmployee, lname)>;
+	using Key = FIELD(EncodedEmployee, company_id);
+};
+
+template <>
+struct Schema<EncodedCompany>
+{
+	using Fields = std::tuple<FIELD(EncodedCompany, id), FIELD(EncodedCompany, name), FIELD(EncodedCompany, slogan)>;
+	using Key = FIELD(EncodedCompany, id);
+};
+
+// Number of fields of a record type
+template <typename T>
+inline constexpr size_t fieldCount = std::tuple_size_v<typename Schema<T>::Fields>;
+
+// Field descriptor at a position
+template <typename T, size_t I>
+using FieldAt = std::tuple_element_t<I, typename Schema<T>::Fields>;
+
+// Type of the key a record type is sorted and joined on
+template <typename T>
+using KeyType = typename Schema<T>::Key::value_type;
+
+/**
+ * @brief Calls a function once per field of a record type, in declaration order.
+ * @tparam T Type of the record.
+ * @param visit Called with a default constructed Field descriptor, e.g. `[](auto field) { decltype(field)::name; }`.
+ */
+template <typename T, typename Visit>
+constexpr auto forEachField(Visit &&visit) -> void
+{
+	std::apply([&visit](auto... fields) { (visit(fields), ...); }, typename Schema<T>::Fields{});
+}
+
+/**
+ * @brief Get the runtime description of every field of a record type.
+ * @tparam T Type of the record.
+ * @return Name, kind, offset and width of each field in declaration order.
+ */
+template <typename T>
+constexpr auto fieldInfos() -> std::array<FieldInfo, fieldCount<T>>
+{
+	std::array<FieldInfo, fieldCount<T>> infos{};
+	size_t i = 0;
+	forEachField<T>([&infos, &i](auto field) {
+		using F = decltype(field);
+		infos[i++] = {F::name, F::kind, F::offset, F::width};
+	});
+	return infos;
+}
+
+/**
+ * @brief Get the position of a field in its schema.
+ * @tparam Member Pointer to the member.
+ * @return The index of the field in declaration order.
+ */
+template <auto Member>
+constexpr auto fieldIndex() -> size_t
+{
+	using T = typename MemberTraits<decltype(Member)>::record_type;
+	size_t index = fieldCount<T>, i = 0;
+	forEachField<T>([&index, &i](auto field) {
+		if constexpr (std::is_same_v<std::remove_cv_t<decltype(decltype(field)::member)>, decltype(Member)>)
+		{
+			if (decltype(field)::member == Member)
+			{
+				index = i;
+			}
+		}
+		++i;
+	});
+	return index;
+}
+
+/**
+ * @brief Get the key a record is sorted and joined on.
+ * @tparam T Type of the record.
+ * @param record The record.
+ * @return Reference to the key field of the record.
+ */
+template <typename T>
+constexpr auto keyOf(const T &record) -> const KeyType<T> &
+{
+	return Schema<T>::Key::get(record);
+}
+
+/**
+ * @brief Orders records by their schema key.
+ */
+struct KeyLess
+{
+	template <typename T>
+	constexpr auto operator()(const T &lhs, const T &rhs) const -> bool
+	{
+		return keyOf(lhs) < keyOf(rhs);
+	}
+};
+
+/**
+ * @brief Get the header line of a record type, the field names separated by ';'.
+ * @tparam T Type of the record.
+ * @return The header line.
+ */
+template <typename T>
+auto recordTitle() -> std::string
+{
+	std::string title;
+	forEachField<T>([&title](auto field) {
+		if (!title.empty())
+		{
+			title += ';';
+		}
+		title += decltype(field)::name;
+	});
+	return title;
+}
+
+/**
+ * @brief Append a record to a text buffer as one line, the fields separated by ';', without the line break.
+ * @tparam T Type of the record.
+ * @param out The buffer to append to.
+ * @param record The record.
+ */
+template <typename T>
+auto appendRecord(std::string &out, const T &record) -> void
+{
+	bool first = true;
+	forEachField<T>([&](auto field) {
+		using F = decltype(field);
+		if (!first)
+		{
+			out += ';';
+		}
+		first = false;
+		if constexpr (F::kind == FieldKind::INTEGER)
+		{
+			char digits[24];
+			auto [last, ec] = std::to_chars(std::begin(digits), std::end(digits), F::get(record));
+			out.append(digits, last);
+		}
+		else
+		{
+			const auto &value = F::get(record);
+			out.append(value.data(), strnlen(value.data(), value.size()));
+		}
+	});
+}
+
+/**
+ * @brief Format a record as one line of text, the fields separated by ';'.
+ * @tparam T Type of the record.
+ * @param record The record.
+ * @return The formatted record.
+ */
+template <typename T>
+auto formatRecord(const T &record) -> std::string
+{
+	std::string line;
+	appendRecord(line, record);
+	return line;
+}
+
+/**
+ * @brief Encodes a record as a variable length tuple, strings are stored with a length prefix instead of their full padded array.
+ * @tparam T Type of the record (e.g., `Employee`, `Company`).
+ * @param record The record to encode.
+ * @return The tuple bytes.
+ */
+template <typename T>
+auto encodeRecord(const T &record) -> std::vector<std::byte>
+{
+	std::vector<std::byte> out;
+	forEachField<T>([&](auto field) {
+		using F = decltype(field);
+		const auto &value = F::get(record);
+		if constexpr (F::kind == FieldKind::INTEGER)
+		{
+			auto bytes = reinterpret_cast<const std::byte *>(&value);
+			out.insert(out.end(), bytes, bytes + F::width);
+		}
+		else
+		{
+			static_assert(F::width < 256, "string length must fit in one byte");
+			size_t length = std::find(value.begin(), value.end(), '\0') - value.begin();
+			out.push_back(std::byte(length));
+			auto bytes = reinterpret_cast<const std::byte *>(value.data());
+			out.insert(out.end(), bytes, bytes + length);
+		}
+	});
+	return out;
+}
+
+/**
+ * @brief Decodes a variable length tuple produced by `encodeRecord`.
+ * @tparam T Type of the record (e.g., `Employee`, `Company`).
+ * @param data The tuple bytes.
+ * @return The decoded record.
+ */
+template <typename T>
+auto decodeRecord(std::span<const std::byte> data) -> T
+{
+	T record{};
+	forEachField<T>([&](auto field) {
+		using F = decltype(field);
+		auto &value = F::get(record);
+		if constexpr (F::kind == FieldKind::INTEGER)
+		{
+			if (data.size() < F::width)
+			{
+				throw std::runtime_error("Tuple is truncated");
+			}
+			std::memcpy(&value, data.data(), F::width);
+			data = data.subspan(F::width);
+		}
+		else
+		{
+			size_t length = data.empty() ? 0 : std::to_integer<size_t>(data[0]);
+			if (data.empty() || data.size() < 1 + length)
+			{
+				throw std::runtime_error("Tuple is truncated");
+			}
+			// a full array has no terminating NUL, so its length is the whole width
+			if (length > F::width)
+			{
+				throw std::runtime_error("Tuple field is longer than its array");
+			}
+			value.fill('\0');
+			std::memcpy(value.data(), data.data() + 1, length);
+			data = data.subspan(1 + length);
+		}
+	});
+	return record;
+}
+
+// Number of records formatted by one export task
+inline constexpr size_t EXPORT_BATCH_RECORDS = 8192;
+
+// Size the export buffer may reach before it is written to the file
+inline constexpr size_t EXPORT_FLUSH_BYTES = 1 MB;
+
+/**
+ * @brief Serializes data from the disk to a text file, converting binary data to objects of type `T`.
+ * @note Result pages are walked in order through pinned frames and formatted with `std::to_chars` into a large buffer.
+ *       With several threads, batches of `EXPORT_BATCH_RECORDS` records are copied out of the pool and formatted concurrently,
+ *       and their text is written in batch order, so the file is the same for any number of threads.
+ * @tparam T Type of object to extract, described by a `Schema` specialization.
+ * @param buffer BufferManager handling disk reads.
+ * @param start Starting address to read from (inclusive).
+ * @param end Ending address to read until (exclusive).
+ * @param fileName Output file name/path for text data.
+ * @param numThreads Number of batches formatted at once by the shared `TaskScheduler`, 1 formats on the calling thread.
+ */
+template <typename T>
+auto storeResult(BufferManager &buffer, address_id_t start, address_id_t end, std::string fileName, unsigned numThreads = 1) -> void
+{
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "Error opening file" << '\n';
+		return;
+	}
+	std::string text = recordTitle<T>() + '\n';
+	text.reserve(EXPORT_FLUSH_BYTES + 1 KB);
+
+	if (numThreads <= 1)
+	{
+		scanRecords<T>(buffer, start, end, [&](std::span<const T> records, address_id_t) {
+			for (const T &record : records)
+			{
+				appendRecord(text, record);
+				text += '\n';
+			}
+			if (text.size() >= EXPORT_FLUSH_BYTES)
+			{
+				file.write(text.data(), text.size());
+				text.clear();
+			}
+		});
+		file.write(text.data(), text.size());
+		return;
+	}
+
+	// the pool is only touched by this thread, formatting tasks work on copied batches
+	file.write(text.data(), text.size());
+	TaskScheduler &scheduler = TaskScheduler::global();
+	std::deque<std::future<std::string>> pending;
+	std::vector<T> batch;
+	batch.reserve(EXPORT_BATCH_RECORDS);
+	auto submit = [&]() {
+		pending.push_back(scheduler.submit([records = std::move(batch)]() {
+			std::string out;
+			out.reserve(records.size() * sizeof(T));
+			for (const T &record : records)
+			{
+				appendRecord(out, record);
+				out += '\n';
+			}
+			return out;
+		}));
+		batch = std::vector<T>();
+		batch.reserve(EXPORT_BATCH_RECORDS);
+		if (pending.size() >= numThreads)
+		{
+			auto out = scheduler.get(pending.front());
+			file.write(out.data(), out.size());
+			pending.pop_front();
+		}
+	};
+	scanRecords<T>(buffer, start, end, [&](std::span<const T> records, address_id_t) {
+		for (const T &record : records)
+		{
+			batch.push_back(record);
+			if (batch.size() == EXPORT_BATCH_RECORDS)
+			{
+				submit();
+			}
+		}
+	});
+	if (!batch.empty())
+	{
+		submit();
+	}
+	for (auto &future : pending)
+	{
+		auto out = scheduler.get(future);
+		file.write(out.data(), out.size());
+	}
+}
+
+	#endif // _SCHEMA_HPP_
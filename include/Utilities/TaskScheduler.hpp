@@ -0,0 +1,203 @@
+#pragma once
+
+	#ifndef _TASK_SCHEDULER_HPP_
+	#define _TASK_SCHEDULER_HPP_
+
+	#include <deque>
+	#include <mutex>
+	#include <atomic>
+	#include <memory>
+	#include <thread>
+	#include <vector>
+	#include <future>
+	#include <chrono>
+	#include <exception>
+	#include <functional>
+	#include <type_traits>
+	#include <condition_variable>
+
+/**
+ * Fixed pool of worker threads shared by every parallel operation, so they split one core budget.
+ * Every worker owns a deque: tasks submitted by a worker go to the back of its own deque and it runs them from the
+ * back, idle workers steal from the front of the others' deques, and tasks submitted from outside the pool are
+ * dealt round robin. A thread waiting on a task group or a future runs pending tasks meanwhile, so tasks may wait
+ * on tasks they submitted without tying up the pool.
+ */
+class TaskScheduler
+{
+	private:
+
+	// deque of one worker
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	// one queue per worker
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+	// the workers
+	std::vector<std::thread> workers;
+
+	// number of queued tasks, workers sleep while it is 0
+	std::atomic<size_t> numQueued;
+
+	// queue that gets the next task submitted from outside the pool
+	std::atomic<size_t> nextQueue;
+
+	// wakes sleeping workers
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+
+	// tells the workers to exit
+	bool stopping;
+
+	// Body of a worker
+	auto workerLoop(unsigned worker) -> void;
+
+	// Take a task, from the back of `worker`'s queue first then from the front of the others'
+	auto takeTask(size_t worker) -> std::function<void()>;
+
+	public:
+
+	/**
+	 * @brief Constructor, starts the workers.
+	 * @param numWorkers Number of worker threads, at least 1.
+	 */
+	explicit TaskScheduler(unsigned numWorkers = std::thread::hardware_concurrency());
+
+	// Destructor, runs the tasks still queued then stops the workers
+	~TaskScheduler();
+
+	TaskScheduler(const TaskScheduler &) = delete;
+	TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+	/**
+	 * @brief Get the scheduler shared by the library, one worker per core.
+	 * @return The shared scheduler, started on first use.
+	 */
+	static auto global() -> TaskScheduler &;
+
+	/**
+	 * @brief Get the number of worker threads.
+	 * @return The number of workers.
+	 */
+	auto getNumWorkers() const -> unsigned
+	{
+		return workers.size();
+	}
+
+	/**
+	 * @brief Queue a task.
+	 * @param task The task, it must not throw.
+	 */
+	auto spawn(std::function<void()> task) -> void;
+
+	/**
+	 * @brief Run one queued task on the calling thread.
+	 * @return false if no task was queued.
+	 */
+	auto runPending() -> bool;
+
+	/**
+	 * @brief Queue a task and get its result later.
+	 * @param task The task.
+	 * @return A future holding the task's result or exception, read it with `get` to help the pool while waiting.
+	 */
+	template <typename Task>
+	auto submit(Task &&task) -> std::future<std::invoke_result_t<std::decay_t<Task>>>
+	{
+		using Result = std::invoke_result_t<std::decay_t<Task>>;
+		auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+		auto future = packaged->get_future();
+		spawn([packaged]() { (*packaged)(); });
+		return future;
+	}
+
+	/**
+	 * @brief Wait for a future, running queued tasks meanwhile.
+	 * @param future The future.
+	 * @return The result, rethrows the task's exception.
+	 */
+	template <typename Result>
+	auto get(std::future<Result> &future) -> Result
+	{
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			if (!runPending())
+			{
+				future.wait_for(std::chrono::milliseconds(1));
+			}
+		}
+		return future.get();
+	}
+};
+
+/**
+ * Set of tasks waited for together.
+ * The first exception a task throws cancels the group and is rethrown by `wait`; tasks of a cancelled group that
+ * have not started are skipped, and running ones may poll `isCancelled` to stop early.
+ */
+class TaskGroup
+{
+	private:
+
+	// state shared with the queued tasks
+	struct State
+	{
+		std::mutex mutex;
+		std::condition_variable done;
+		size_t pending = 0;
+		std::exception_ptr error;
+		std::atomic<bool> cancelled = false;
+	};
+
+	// scheduler running the tasks
+	TaskScheduler *scheduler;
+
+	// shared state
+	std::shared_ptr<State> state;
+
+	public:
+
+	/**
+	 * @brief Constructor
+	 * @param _scheduler Scheduler to run the tasks on.
+	 */
+	explicit TaskGroup(TaskScheduler &_scheduler = TaskScheduler::global());
+
+	// Destructor, waits for the tasks, dropping their exception
+	~TaskGroup();
+
+	TaskGroup(const TaskGroup &) = delete;
+	TaskGroup &operator=(const TaskGroup &) = delete;
+
+	/**
+	 * @brief Queue a task in the group.
+	 * @param task The task.
+	 */
+	auto run(std::function<void()> task) -> void;
+
+	/**
+	 * @brief Skip the tasks that have not started and tell running ones to stop.
+	 */
+	auto cancel() -> void;
+
+	/**
+	 * @brief Tells whether the group was cancelled, by `cancel` or by a failed task.
+	 * @return true once cancelled.
+	 */
+	auto isCancelled() const -> bool
+	{
+		return state->cancelled;
+	}
+
+	/**
+	 * @brief Wait for every task, running queued tasks meanwhile.
+	 * @note Rethrows the first exception thrown by a task.
+	 */
+	auto wait() -> void;
+};
+
+	#endif // _TASK_SCHEDULER_HPP_
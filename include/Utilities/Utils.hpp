@@ -10,6 +10,11 @@
 	#include <vector>
 	#include <string>
 	#include <sstream>
+	#include <cstring>
+	#include <cstddef>
+	#include <span>
+	#include <cstdint>
+	#include <functional>
 
 using frame_id_t = unsigned long long;
 using page_id_t = unsigned long long;
@@ -31,6 +36,12 @@ using storage_t = unsigned long long;
 #define DISK_SIZE (4 MB)
 #define BUFFER_SIZE (64 KB)
 
+// number of pages read from an input file and written to the disk at once when loading
+#define LOAD_CHUNK_PAGES 64
+
+// number of threads the binaries sort, join and export with, fixed so their statistics do not depend on the machine
+#define DRIVER_THREADS 4
+
 const std::string BIN_DIR = "./bin/";
 const std::string CSV_DIR = "./files_large/";
 const std::string RES_DIR = "./Results/";
@@ -61,17 +72,6 @@ struct Employee
 	{
 		return lhs.company_id <=> rhs.company_id;
 	}
-	
-	static std::string getTitle() {
-		return "id;company_id;salary;fname;lname";
-	}
-
-	std::string toString() const {
-		std::stringstream ss;
-		ss << id << ";" << company_id << ";" << salary << ";"
-		   << fname.data() << ";" << lname.data();
-		return ss.str();
-	}
 };
 
 struct Company
@@ -91,16 +91,6 @@ struct Company
 	{
 		return lhs.id <=> rhs.id;
 	}
-
-	static std::string getTitle() {
-		return "id;name;slogan";
-	}
-
-	std::string toString() const {
-		std::stringstream ss;
-		ss << id << ";" << name.data() << ";" << slogan.data();
-		return ss.str();
-	}
 };
 
 struct JoinEmployeeCompany
@@ -126,20 +116,45 @@ struct JoinEmployeeCompany
 		std::copy_n(company.name.begin(), 62, name.begin());
 		std::copy_n(company.slogan.begin(), 62, slogan.begin());
 	}
+};
 
-	static std::string getTitle() {
-		return "employee_id;company_id;salary;fname;lname;name;slogan";
-	}
+// Employee with its names stored as codes into the employee table's string dictionary
+struct EncodedEmployee
+{
+	int id;
+	int company_id;
+	int salary;
+	uint32_t fname;
+	uint32_t lname;
+};
 
-	std::string toString() const {
-        std::stringstream ss;
-		ss << employee_id << ";" << company_id << ";" << salary << ";"
-		   << fname.data() << ";" << lname.data() << ";"
-		   << name.data() << ";" << slogan.data();
-        return ss.str();
-    }
+// Company with its name and slogan stored as codes into the company table's string dictionary
+struct EncodedCompany
+{
+	int id;
+	uint32_t name;
+	uint32_t slogan;
 };
 
+// Maps a record type to its dictionary encoded form
+template <typename T>
+struct Encoded;
+
+template <>
+struct Encoded<Employee>
+{
+	using type = EncodedEmployee;
+};
+
+template <>
+struct Encoded<Company>
+{
+	using type = EncodedCompany;
+};
+
+template <typename T>
+using EncodedType = typename Encoded<T>::type;
+
 struct Stats
 {
 	long long numIO = 0;
@@ -179,14 +194,28 @@ static constexpr auto CompanySize = sizeof(Company);
 static constexpr auto JoinedSize = sizeof(JoinEmployeeCompany);
 
 /**
- * @brief Loads a file into the disk in 128-byte chunks.
+ * @brief Writes data to the disk, whole pages with multi-block writes that bypass the buffer pool.
+ * @note Only a partial first or last page is merged through the pool.
+ * @param buffer Reference to the BufferManager that handles writing data to disk.
+ * @param address The address to write to.
+ * @param data The data to write.
+ */
+auto bulkWrite (BufferManager& buffer, address_id_t address, std::span<const std::byte> data) -> void;
+
+// Called with each chunk of a file as it is loaded, e.g. to build summaries without reading the data back
+using LoadObserver = std::function<void(address_id_t address, std::span<const std::byte> data)>;
+
+/**
+ * @brief Loads a file into the disk, streaming it in chunks of `LOAD_CHUNK_PAGES` pages.
+ * @note Chunks are written with `bulkWrite`.
  * @param buffer Reference to the BufferManager that handles writing data to disk.
  * @param fileName Name (or path) of the file to be loaded.
  * @param startingAddress The address in the buffer where writing should begin.
+ * @param observe Called with every chunk after it is written, in address order.
  * @return On success, returns a pair of (startingAddress, endAddress) indicating the range written.
  *         Returns std::nullopt if the file cannot be opened or an error occurs.
  */
-auto loadFileInDisk (BufferManager& buffer, std::string fileName, address_id_t startingAddress) -> std::optional<std::pair<address_id_t,address_id_t>>;
+auto loadFileInDisk (BufferManager& buffer, std::string fileName, address_id_t startingAddress, const LoadObserver &observe = {}) -> std::optional<std::pair<address_id_t,address_id_t>>;
 
 /**
  * @brief Calculates the starting address of the next free frame given the current Address and the block size.
@@ -203,30 +232,37 @@ auto getNextFreeFrame(int readBytes, block_id_t blockSize = (4 KB)) -> int;
  * @return T Deserialized object populated from `data`.
  */
 template <typename T>
-T extractData(const std::vector<std::byte> &data);
+auto extractData(const std::vector<std::byte> &data) -> T
+{
+	T result;
+	std::memcpy(&result, data.data(), sizeof(T));
+	return result;
+}
 
 /**
  * @brief Loads "employee.bin" and "company.bin" files into disk storage via a buffer manager.
+ * @note The disk's allocation map is formatted first, then each file gets its own extent.
  * @param BLOCK_SIZE Size of each disk block (in bytes).
  * @param DISK_SIZE Total capacity of the disk (in bytes).
  * @param BUFFER_SIZE Maximum buffer cache size (in bytes).
+ * @param observeEmployees Called with the employee data as it is loaded.
+ * @param observeCompanies Called with the company data as it is loaded.
  * @return Contains four addresses in order:
  *         - Start of employee data
  *         - End of employee data
  *         - Start of company data
  *         - End of company data
  */
-auto loadData(block_id_t blockSize = (4 KB), storage_t diskSize = (4 MB), storage_t bufferSize = (64 KB)) -> std::tuple<address_id_t, address_id_t, address_id_t, address_id_t>;
+auto loadData(block_id_t blockSize = (4 KB), storage_t diskSize = (4 MB), storage_t bufferSize = (64 KB), const LoadObserver &observeEmployees = {}, const LoadObserver &observeCompanies = {}) -> std::tuple<address_id_t, address_id_t, address_id_t, address_id_t>;
 
 /**
- * @brief Serializes data from the disk to a text file, converting binary data to objects of type `T`.
- * @tparam T Type of object to extract (requires `T::size` and `T::toString()` methods).
- * @param buffer BufferManager handling disk reads.
- * @param start Starting address to read from (inclusive).
- * @param end Ending address to read until (exclusive).
- * @param fileName Output file name/path for text data.
+ * @brief Loads "employee.bin" and "company.bin" files into disk storage through an existing buffer manager.
+ * @note Same as `loadData` above, but no temporary disk and buffer manager are created.
+ * @param buffer BufferManager of the disk to load into.
+ * @param observeEmployees Called with the employee data as it is loaded.
+ * @param observeCompanies Called with the company data as it is loaded.
+ * @return The start and end addresses of the employee and company data, as for `loadData` above.
  */
-template <typename T>
-auto storeResult(BufferManager &buffer, address_id_t start, address_id_t end, std::string fileName) -> void;
+auto loadData(BufferManager &buffer, const LoadObserver &observeEmployees = {}, const LoadObserver &observeCompanies = {}) -> std::tuple<address_id_t, address_id_t, address_id_t, address_id_t>;
 
 #endif // _UTILS_HPP_
\ No newline at end of file
@@ -0,0 +1,265 @@
+#pragma once
+
+	#ifndef _ZONE_MAP_HPP_
+	#define _ZONE_MAP_HPP_
+
+	#include <span>
+	#include <vector>
+	#include <limits>
+	#include <cstdint>
+	#include <cstring>
+	#include <stdexcept>
+	#include <algorithm>
+	#include <initializer_list>
+
+	#include <Utilities/Utils.hpp>
+	#include <Utilities/Schema.hpp>
+	#include <Storage/BufferManager.hpp>
+	#include <Storage/RecordView.hpp>
+
+// Smallest and largest value of a column among the records starting in one page
+struct Zone
+{
+	int64_t min = std::numeric_limits<int64_t>::max();
+	int64_t max = std::numeric_limits<int64_t>::min();
+
+	// true if no record was summarised
+	auto empty() const -> bool
+	{
+		return min > max;
+	}
+};
+
+/**
+ * Per page min/max summaries of chosen integer columns of a relation of records of type `T`.
+ * A record is summarised in the page it starts in, so a page whose zone cannot satisfy a predicate holds no match
+ * and scans skip it without reading it. Zones only ever widen: an overwritten record leaves its old value in the
+ * zone, which keeps the summary correct though less selective. Pages that were never summarised are always read.
+ * @tparam T Type of the records, described by a `Schema` specialization.
+ */
+template <typename T>
+class ZoneMap
+{
+	private:
+
+	// size of a page in bytes
+	storage_t blockSize;
+
+	// schema field index of each summarised column
+	std::vector<size_t> columns;
+
+	// page of the first zone
+	page_id_t firstPage = 0;
+
+	// zones of each page from firstPage, page major
+	std::vector<Zone> zones;
+
+	// leading bytes of a record split between two observed chunks
+	std::vector<std::byte> partial;
+
+	// address of the record in partial, or of the next observed chunk
+	address_id_t nextAddress = 0;
+
+	// position of a field in columns
+	auto slotOf(size_t field) const -> size_t
+	{
+		auto it = std::find(columns.begin(), columns.end(), field);
+		if (it == columns.end())
+		{
+			throw std::invalid_argument("Column has no zone map");
+		}
+		return it - columns.begin();
+	}
+
+	// zones of a page, created empty if needed
+	auto zonesOf(page_id_t page) -> Zone *
+	{
+		if (zones.empty())
+		{
+			firstPage = page;
+		}
+		else if (page < firstPage)
+		{
+			zones.insert(zones.begin(), (firstPage - page) * columns.size(), Zone{});
+			firstPage = page;
+		}
+		size_t index = (page - firstPage) * columns.size();
+		if (index + columns.size() > zones.size())
+		{
+			zones.resize(index + columns.size());
+		}
+		return zones.data() + index;
+	}
+
+	// address of the first record of the relation at `start` that starts after `page`
+	auto nextRecordAfter(address_id_t start, page_id_t page) const -> address_id_t
+	{
+		address_id_t pageEnd = static_cast<address_id_t>(page + 1) * blockSize;
+		return start + (pageEnd - start + sizeof(T) - 1) / sizeof(T) * sizeof(T);
+	}
+
+	public:
+
+	/**
+	 * @brief Constructor
+	 * @param _blockSize Size of a page in bytes.
+	 * @param _columns Schema field indices of the integer columns to summarise, e.g. `fieldIndex<&Employee::salary>()`.
+	 */
+	ZoneMap(storage_t _blockSize, std::initializer_list<size_t> _columns) : blockSize(_blockSize), columns(_columns)
+	{
+		static constexpr auto fields = fieldInfos<T>();
+		for (size_t field : columns)
+		{
+			if (field >= fields.size() || fields[field].kind != FieldKind::INTEGER)
+			{
+				throw std::invalid_argument("Zone maps summarise integer columns only");
+			}
+		}
+	}
+
+	/**
+	 * @brief Summarise a record written to the disk.
+	 * @param address The address of the record.
+	 * @param record The record.
+	 */
+	auto add(address_id_t address, const T &record) -> void
+	{
+		static constexpr auto fields = fieldInfos<T>();
+		Zone *zone = zonesOf(address / blockSize);
+		auto bytes = reinterpret_cast<const std::byte *>(&record);
+		for (size_t slot = 0; slot < columns.size(); ++slot)
+		{
+			const FieldInfo &field = fields[columns[slot]];
+			int64_t value = readInteger(bytes + field.offset, field.width);
+			zone[slot].min = std::min(zone[slot].min, value);
+			zone[slot].max = std::max(zone[slot].max, value);
+		}
+	}
+
+	/**
+	 * @brief Summarise records written back to back, fed chunk by chunk in address order, e.g. as a `LoadObserver`.
+	 * @param address The address of the chunk, the first chunk must start on a record.
+	 * @param data The bytes of the chunk, a record may be split between two chunks.
+	 */
+	auto observe(address_id_t address, std::span<const std::byte> data) -> void
+	{
+		if (address != nextAddress + partial.size())
+		{
+			partial.clear();
+			nextAddress = address;
+		}
+		T record;
+		if (!partial.empty())
+		{
+			size_t missing = std::min(sizeof(T) - partial.size(), data.size());
+			partial.insert(partial.end(), data.begin(), data.begin() + missing);
+			data = data.subspan(missing);
+			address += missing;
+			if (partial.size() < sizeof(T))
+			{
+				return;
+			}
+			std::memcpy(&record, partial.data(), sizeof(T));
+			add(nextAddress, record);
+			partial.clear();
+		}
+		for (; data.size() >= sizeof(T); data = data.subspan(sizeof(T)), address += sizeof(T))
+		{
+			std::memcpy(&record, data.data(), sizeof(T));
+			add(address, record);
+		}
+		partial.assign(data.begin(), data.end());
+		nextAddress = address;
+	}
+
+	/**
+	 * @brief Summarise records already on the disk, reading them once.
+	 * @param buffer BufferManager holding the pages.
+	 * @param start Address of the first record (inclusive).
+	 * @param end Address one past the last record (exclusive).
+	 */
+	auto build(BufferManager &buffer, address_id_t start, address_id_t end) -> void
+	{
+		scanRecords<T>(buffer, start, end, [this](std::span<const T> records, address_id_t address) {
+			for (const T &record : records)
+			{
+				add(address, record);
+				address += sizeof(T);
+			}
+		});
+	}
+
+	/**
+	 * @brief Get the zone of a column in a page.
+	 * @param page The page.
+	 * @param field Schema field index of the column.
+	 * @return The zone, empty if no record starting in the page was summarised.
+	 */
+	auto getZone(page_id_t page, size_t field) const -> Zone
+	{
+		size_t slot = slotOf(field);
+		if (page < firstPage || (page - firstPage + 1) * columns.size() > zones.size())
+		{
+			return Zone{};
+		}
+		return zones[(page - firstPage) * columns.size() + slot];
+	}
+
+	/**
+	 * @brief Tells whether a page may hold a record whose column lies in [low, high].
+	 * @param page The page.
+	 * @param field Schema field index of the column.
+	 * @param low Smallest wanted value (inclusive).
+	 * @param high Largest wanted value (inclusive).
+	 * @return false only if no record starting in the page can match.
+	 */
+	auto mayMatch(page_id_t page, size_t field, int64_t low, int64_t high) const -> bool
+	{
+		Zone zone = getZone(page, field);
+		return zone.empty() || (zone.max >= low && zone.min <= high);
+	}
+
+	/**
+	 * @brief Visits the records of the pages that may hold a record whose column lies in [low, high].
+	 * @param buffer BufferManager holding the pages.
+	 * @param start Address of the first record (inclusive).
+	 * @param end Address one past the last record (exclusive).
+	 * @param field Schema field index of the column.
+	 * @param low Smallest wanted value (inclusive).
+	 * @param high Largest wanted value (inclusive).
+	 * @param visit Called as by `scanRecords`, the records still have to be filtered.
+	 * @return The number of pages skipped without reading them.
+	 */
+	template <typename Visit>
+	auto scan(BufferManager &buffer, address_id_t start, address_id_t end, size_t field, int64_t low, int64_t high, Visit &&visit) const -> size_t
+	{
+		if (buffer.getBlockSize() != blockSize)
+		{
+			throw std::invalid_argument("Zone map was built for another page size");
+		}
+		size_t skipped = 0;
+		address_id_t address = start;
+		while (address + sizeof(T) <= end)
+		{
+			page_id_t page = address / blockSize;
+			if (!mayMatch(page, field, low, high))
+			{
+				address = nextRecordAfter(start, page);
+				++skipped;
+				continue;
+			}
+
+			// consecutive pages that may match are scanned together
+			address_id_t runEnd = nextRecordAfter(start, page);
+			while (runEnd + sizeof(T) <= end && mayMatch(runEnd / blockSize, field, low, high))
+			{
+				runEnd = nextRecordAfter(start, runEnd / blockSize);
+			}
+			scanRecords<T>(buffer, address, std::min(runEnd, end), visit);
+			address = runEnd;
+		}
+		return skipped;
+	}
+};
+
+	#endif // _ZONE_MAP_HPP_
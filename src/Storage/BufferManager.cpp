@@ -1,6 +1,8 @@
 #include <Utilities/Utils.hpp>
 #include <Storage/BufferManager.hpp>
 #include <ostream>
+#include <iostream>
+#include <fstream>
 
 BufferManager::BufferManager ( Disk *_disk, int _replaceStrategy, storage_t _bufferSize )
     : disk( _disk ),
@@ -10,7 +12,12 @@ BufferManager::BufferManager ( Disk *_disk, int _replaceStrategy, storage_t _buf
       bufferData( _bufferSize / disk->blockSize,
       std::vector< std::byte >( disk->blockSize ) ),
       pinCount( _bufferSize / disk->blockSize, 0 ),
-      isDirty( _bufferSize / disk->blockSize, false )
+      isDirty( _bufferSize / disk->blockSize, false ),
+      accessCount( _bufferSize / disk->blockSize, 0 ),
+      warmupCount( 0 ),
+      stopWarmup( false ),
+      numWarmReads( 0 ),
+      numTierHits( 0 )
 {
     for ( frame_id_t i = 0; i < numFrames; ++i )
     {
@@ -20,16 +27,69 @@ BufferManager::BufferManager ( Disk *_disk, int _replaceStrategy, storage_t _buf
 
 BufferManager::~BufferManager ()
 {
+    // a sidecar that cannot be written only costs the next warm-up, the dirty frames below must still be flushed
+    if ( !warmupFile.empty() )
+    {
+        try
+        {
+            saveHotPages( warmupFile, warmupCount );
+        }
+        catch ( const std::exception &error )
+        {
+            std::cerr << "Hot pages not saved to " << warmupFile << ": " << error.what() << std::endl;
+        }
+    }
+    stopWarmup = true;
+    if ( warmThread.joinable() )
+    {
+        warmThread.join();
+    }
     for ( frame_id_t i = 0; i < numFrames; ++i )
     {
         if ( isDirty[i] )
         {
-            disk->writeBlock( invPageTable[i], bufferData[i] );
+            flushFrame( i );
             isDirty[i] = false;
         }
     }
 }
 
+auto BufferManager::fetchBlock ( page_id_t pageNumber ) -> std::vector< std::byte >
+{
+    if ( compressedTier.has_value() )
+    {
+        auto data = compressedTier->take( pageNumber );
+        if ( data.has_value() )
+        {
+            ++numTierHits;
+            return std::move( data.value() );
+        }
+    }
+    if ( warmThread.joinable() )
+    {
+        std::lock_guard< std::mutex > lock( warmMutex );
+        auto it = warmPages.find( pageNumber );
+        if ( it != warmPages.end() )
+        {
+            auto data = std::move( it->second );
+            warmPages.erase( it );
+            return data;
+        }
+    }
+    return disk->readBlock( pageNumber );
+}
+
+auto BufferManager::flushFrame ( frame_id_t frame ) -> void
+{
+    if ( warmThread.joinable() )
+    {
+        std::lock_guard< std::mutex > lock( warmMutex );
+        warmPages.erase( invPageTable[frame] );
+        staleWarmPages.insert( invPageTable[frame] );
+    }
+    disk->writeBlock( invPageTable[frame], bufferData[frame] );
+}
+
 auto BufferManager::findVictim ( ) -> std::optional< frame_id_t >
 {
     if( replaceStrategy == LRU )
@@ -40,7 +100,12 @@ auto BufferManager::findVictim ( ) -> std::optional< frame_id_t >
             {
                 if ( isDirty[*it] )
                 {
-                    disk->writeBlock( invPageTable[*it], bufferData[*it] );
+                    flushFrame( *it );
+                    isDirty[*it] = false;
+                }
+                if ( compressedTier.has_value() )
+                {
+                    compressedTier->put( invPageTable[*it], bufferData[*it] );
                 }
                 auto frame = *it;
                 busyFrames.erase( it );
@@ -59,7 +124,12 @@ auto BufferManager::findVictim ( ) -> std::optional< frame_id_t >
             {
                 if ( isDirty[*it] )
                 {
-                    disk->writeBlock( invPageTable[*it], bufferData[*it] );
+                    flushFrame( *it );
+                    isDirty[*it] = false;
+                }
+                if ( compressedTier.has_value() )
+                {
+                    compressedTier->put( invPageTable[*it], bufferData[*it] );
                 }
                 auto frame = *it;
                 busyFrames.erase( std::next( it ).base() );
@@ -100,7 +170,8 @@ auto BufferManager::getFrame ( page_id_t pageNumber ) -> std::optional< frame_id
             framePos[frame.value()] = std::prev( busyFrames.end() );
             pageTable[pageNumber] = frame.value();
             invPageTable[frame.value()] = pageNumber;
-            bufferData[frame.value()] = disk->readBlock( pageNumber );
+            bufferData[frame.value()] = fetchBlock( pageNumber );
+            accessCount[frame.value()] = 0;
         }
         else
         {
@@ -109,6 +180,7 @@ auto BufferManager::getFrame ( page_id_t pageNumber ) -> std::optional< frame_id
     }
 
     frame_id_t frame = pageTable[pageNumber];
+    ++accessCount[frame];
 
     // Update the position of the frame in the busy list
     auto it = framePos.find( frame );
@@ -124,7 +196,7 @@ auto BufferManager::getFrame ( page_id_t pageNumber ) -> std::optional< frame_id
 }
 
 
-auto BufferManager::readPage ( page_id_t pageNumber ) -> std::vector< std::byte >
+auto BufferManager::residentFrame ( page_id_t pageNumber ) -> frame_id_t
 {
     if( pageNumber >= disk->blockCount )
     {
@@ -133,7 +205,7 @@ auto BufferManager::readPage ( page_id_t pageNumber ) -> std::vector< std::byte
     auto frameNumber = getFrame( pageNumber );
     if(frameNumber.has_value())
     {
-        return bufferData[ frameNumber.value() ];
+        return frameNumber.value();
     }
     else
     {
@@ -141,98 +213,135 @@ auto BufferManager::readPage ( page_id_t pageNumber ) -> std::vector< std::byte
     }
 }
 
-auto BufferManager::writePage ( page_id_t pageNumber, const std::vector< std::byte > &data ) -> void
+auto BufferManager::readAddress ( address_id_t address, storage_t size ) -> std::vector< std::byte >
 {
-    if( pageNumber >= disk->blockCount )
-    {
-        throw std::runtime_error( "Page number out of range");
-    }
-    auto frameNumber = getFrame( pageNumber );
-    if(frameNumber.has_value())
-    {
-        bufferData[frameNumber.value()] = data;
-        isDirty[frameNumber.value()] = true;
-    }
-    else
+    std::lock_guard< std::recursive_mutex > lock( poolMutex );
+    ++numIO;
+    auto pageNumber = address / disk->blockSize;
+    auto offset = address % disk->blockSize;
+
+    std::vector< std::byte > data( size );
+    storage_t copied = 0;
+
+    // copy straight out of each frame, a page is only needed until its part is copied
+    while( copied < size )
     {
-        throw std::runtime_error( "Buffer space full");
+        const auto &frame = bufferData[ residentFrame( pageNumber ) ];
+        storage_t bytesToCopy = std::min( size - copied, disk->blockSize - offset );
+        std::copy( frame.begin() + offset, frame.begin() + offset + bytesToCopy, data.begin() + copied );
+        copied += bytesToCopy;
+        offset = 0;
+        pageNumber++;
     }
+    return data;
 }
 
-auto BufferManager::readAddress ( address_id_t address, storage_t size ) -> std::vector< std::byte >
+auto BufferManager::writeAddress ( address_id_t address, std::span< const std::byte > data ) -> void
 {
+    std::lock_guard< std::recursive_mutex > lock( poolMutex );
     ++numIO;
     auto pageNumber = address / disk->blockSize;
     auto offset = address % disk->blockSize;
 
-    std::vector< std::byte > data( size );
-    auto firstFrame = readPage( pageNumber );
+    storage_t copied = 0;
+    while( copied < data.size() )
+    {
+        auto frameNumber = residentFrame( pageNumber );
+        storage_t bytesToCopy = std::min( data.size() - copied, disk->blockSize - offset );
+        std::copy( data.begin() + copied, data.begin() + copied + bytesToCopy, bufferData[frameNumber].begin() + offset );
+        isDirty[frameNumber] = true;
+        copied += bytesToCopy;
+        offset = 0;
+        pageNumber++;
+    }
+    return;
+}
 
-    if( offset + size <= disk->blockSize )
+auto BufferManager::writePages ( page_id_t firstPage, std::span< const std::byte > data ) -> void
+{
+    std::lock_guard< std::recursive_mutex > lock( poolMutex );
+    ++numIO;
+    size_t count = data.size() / disk->blockSize;
+    for ( page_id_t page = firstPage; page < firstPage + count; ++page )
     {
-        std::copy( firstFrame.begin() + offset, firstFrame.begin() + offset + size, data.begin() );
+        auto it = pageTable.find( page );
+        if ( it != pageTable.end() )
+        {
+            if ( pinCount[it->second] > 0 )
+            {
+                throw std::runtime_error( "Page is pinned" );
+            }
+            dropFrame( it->second );
+        }
+        if ( compressedTier.has_value() )
+        {
+            compressedTier->erase( page );
+        }
     }
-    else
+    if ( warmThread.joinable() )
     {
-        std::copy( firstFrame.begin() + offset, firstFrame.end(), data.begin() );
-        
-        storage_t remainingSize = size - ( disk->blockSize - offset );
-
-        while( remainingSize > 0 )
+        std::lock_guard< std::mutex > lock( warmMutex );
+        for ( page_id_t page = firstPage; page < firstPage + count; ++page )
         {
-            pageNumber++;
-            auto nextFrame = readPage( pageNumber );
-            storage_t bytesToCopy = std::min( remainingSize, disk->blockSize );
-            std::copy( nextFrame.begin(), nextFrame.begin() + bytesToCopy, data.begin() + size - remainingSize );
-            remainingSize -= bytesToCopy;
+            warmPages.erase( page );
+            staleWarmPages.insert( page );
         }
     }
-    return data;
+    disk->writeBlocks( firstPage, data );
 }
 
-auto BufferManager::writeAddress ( address_id_t address, const std::vector< std::byte > &data ) -> void
+auto BufferManager::dropFrame ( frame_id_t frame ) -> void
 {
-    ++numIO;
-    auto pageNumber = address / disk->blockSize;
-    auto offset = address % disk->blockSize;
+    busyFrames.erase( framePos[frame] );
+    framePos.erase( frame );
+    pageTable.erase( invPageTable[frame] );
+    invPageTable.erase( frame );
+    isDirty[frame] = false;
+    accessCount[frame] = 0;
+    freeFrames.push( frame );
+}
 
-    auto firstFrame = readPage( pageNumber );
+auto BufferManager::pinPage ( page_id_t pageNumber ) -> PageGuard
+{
+    std::lock_guard< std::recursive_mutex > lock( poolMutex );
+    ++numIO;
+    auto frameNumber = residentFrame( pageNumber );
+    ++pinCount[frameNumber];
+    return PageGuard( this, frameNumber, bufferData[frameNumber].data() );
+}
 
-    if( offset + data.size() <= disk->blockSize )
+auto BufferManager::unpinFrame ( frame_id_t frame, bool dirty ) -> void
+{
+    std::lock_guard< std::recursive_mutex > lock( poolMutex );
+    if ( pinCount[frame] > 0 )
     {
-        std::copy( data.begin(), data.end(), firstFrame.begin() + offset );
-        writePage( pageNumber, firstFrame );
+        --pinCount[frame];
     }
-    else
+    if ( dirty )
     {
-        std::copy( data.begin(), data.begin() + disk->blockSize - offset, firstFrame.begin() + offset );
-        writePage( pageNumber, firstFrame );
-        
-        storage_t remainingSize = data.size() - ( disk->blockSize - offset );
-
-        while( remainingSize > 0 )
-        {
-            pageNumber++;
-            auto nextFrame = readPage( pageNumber );
-            storage_t bytesToCopy = std::min( remainingSize, disk->blockSize );
-            std::copy( data.begin() + data.size() - remainingSize, data.begin() + data.size() - remainingSize + bytesToCopy, nextFrame.begin() );
-            remainingSize -= bytesToCopy;
-            
-            writePage( pageNumber, nextFrame );
-        }
+        isDirty[frame] = true;
     }
-    return;
+}
+
+auto BufferManager::touchFrame ( frame_id_t frame, size_t accesses ) -> void
+{
+    std::lock_guard< std::recursive_mutex > lock( poolMutex );
+    numIO += accesses;
+    accessCount[frame] += accesses;
+    busyFrames.splice( busyFrames.end(), busyFrames, framePos[frame] );
 }
 
 auto BufferManager::clearCache() -> void
 {
+    std::lock_guard< std::recursive_mutex > lock( poolMutex );
     for ( frame_id_t i = 0; i < numFrames; ++i )
     {
         if ( isDirty[i] )
         {
-            disk->writeBlock( invPageTable[i], bufferData[i] );
+            flushFrame( i );
             isDirty[i] = false;
         }
+        accessCount[i] = 0;
     }
     busyFrames.clear();
     freeFrames = std::stack<frame_id_t>();
@@ -243,11 +352,117 @@ auto BufferManager::clearCache() -> void
     pageTable.clear();
     invPageTable.clear();
     framePos.clear();
+    if ( compressedTier.has_value() )
+    {
+        compressedTier->clear();
+    }
 
     disk->diskFileStream.seekg( 0, std::ios::beg );
     disk->diskFileStream.seekp( 0, std::ios::end );
 }
 
+auto BufferManager::saveHotPages ( std::string fileName, size_t count ) -> void
+{
+    std::lock_guard< std::recursive_mutex > lock( poolMutex );
+    // busy list is ordered by recency, so a stable sort keeps the most recent page first among ties
+    std::vector< page_id_t > pages;
+    std::vector< frame_id_t > frames( busyFrames.rbegin(), busyFrames.rend() );
+    std::stable_sort( frames.begin(), frames.end(), [this]( frame_id_t a, frame_id_t b ) {
+        return accessCount[a] > accessCount[b];
+    });
+    if ( count == 0 || count > frames.size() )
+    {
+        count = frames.size();
+    }
+    for ( size_t i = 0; i < count; ++i )
+    {
+        pages.push_back( invPageTable[frames[i]] );
+    }
+
+    std::ofstream file( fileName, std::ios::binary | std::ios::trunc );
+    if ( !file.is_open() )
+    {
+        throw std::runtime_error( "Warm-up file could not be opened" );
+    }
+    size_t size = pages.size();
+    file.write( reinterpret_cast< const char * >( &size ), sizeof( size ) );
+    file.write( reinterpret_cast< const char * >( pages.data() ), size * sizeof( page_id_t ) );
+}
+
+auto BufferManager::enableWarmup ( std::string fileName, size_t count ) -> void
+{
+    std::lock_guard< std::recursive_mutex > lock( poolMutex );
+    warmupFile = fileName;
+    warmupCount = count;
+    if ( warmThread.joinable() )
+    {
+        return;
+    }
+
+    std::ifstream file( fileName, std::ios::binary );
+    if ( !file.is_open() )
+    {
+        return;
+    }
+    size_t size = 0;
+    file.read( reinterpret_cast< char * >( &size ), sizeof( size ) );
+    std::vector< page_id_t > pages( size );
+    file.read( reinterpret_cast< char * >( pages.data() ), size * sizeof( page_id_t ) );
+    if ( !file )
+    {
+        return;
+    }
+
+    // read in block order so the warm-up itself is a sequential pass over the disk
+    std::sort( pages.begin(), pages.end() );
+    pages.erase( std::unique( pages.begin(), pages.end() ), pages.end() );
+    pages.erase( std::remove_if( pages.begin(), pages.end(), [this]( page_id_t page ) {
+        return page >= disk->blockCount || pageTable.count( page );
+    }), pages.end() );
+
+    // the warm-up thread reads through its own stream, so buffered writes must reach the file first
+    disk->diskFileStream.flush();
+    stopWarmup = false;
+    warmThread = std::thread( &BufferManager::warmupWorker, this, std::move( pages ) );
+}
+
+auto BufferManager::enableCompressedTier ( storage_t capacity ) -> void
+{
+    std::lock_guard< std::recursive_mutex > lock( poolMutex );
+    compressedTier.emplace( capacity, disk->blockSize );
+}
+
+auto BufferManager::warmupWorker ( std::vector< page_id_t > pages ) -> void
+{
+    // separate stream so the foreground never shares a file position with this thread
+    std::ifstream file( disk->diskFile, std::ios::binary );
+    if ( !file.is_open() )
+    {
+        return;
+    }
+    for ( auto page : pages )
+    {
+        if ( stopWarmup )
+        {
+            break;
+        }
+        std::vector< std::byte > data( disk->blockSize );
+        file.seekg( page * disk->blockSize, std::ios::beg );
+        file.read( reinterpret_cast< char * >( data.data() ), disk->blockSize );
+        if ( !file )
+        {
+            break;
+        }
+
+        std::lock_guard< std::mutex > lock( warmMutex );
+        if ( !staleWarmPages.count( page ) )
+        {
+            warmPages.emplace( page, std::move( data ) );
+        }
+        ++numWarmReads;
+    }
+}
+
 auto BufferManager::printStats ( std::ostream &os, Stats &startStats, std::string header ) -> void
 {
     Stats endStats = getStats();
@@ -265,7 +480,32 @@ auto BufferManager::printStats ( std::ostream &os, Stats &startStats, std::strin
     os << "\tNumber of memory accesses: " << endStats.numIO << std::endl;
     os << "\tNumber of block read/write: " << endStats.numDiskAccess << std::endl;
     os << "\tCost of disk accesses: " << endStats.costDiskAccess << std::endl;
+    if ( !warmupFile.empty() )
+    {
+        os << "\tNumber of warm-up block reads: " << numWarmReads << std::endl;
+    }
+    if ( compressedTier.has_value() )
+    {
+        os << "\tNumber of compressed tier hits: " << numTierHits << std::endl;
+    }
     os << "\t================================================" << std::endl;
     os << std::endl;
     return;
-}
\ No newline at end of file
+}
+
+auto PageGuard::touch ( size_t accesses ) -> void
+{
+    if ( buffer_manager != nullptr && accesses > 0 )
+    {
+        buffer_manager->touchFrame( frame, accesses );
+    }
+}
+
+auto PageGuard::release ( ) -> void
+{
+    if ( buffer_manager != nullptr )
+    {
+        buffer_manager->unpinFrame( frame, dirty );
+        buffer_manager = nullptr;
+    }
+}
@@ -0,0 +1,223 @@
+#include <Storage/CompressedTier.hpp>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+// minimum match length, shorter matches cost more than the literals they replace
+static constexpr size_t MIN_MATCH = 4;
+
+// matches are addressed with a two byte offset
+static constexpr size_t MAX_OFFSET = 65535;
+
+// number of bits used to index the match finder hash table
+static constexpr int HASH_BITS = 12;
+
+static auto read32 ( const std::byte *p ) -> uint32_t
+{
+    uint32_t value;
+    std::memcpy( &value, p, sizeof( value ) );
+    return value;
+}
+
+static auto writeLength ( std::vector< std::byte > &out, size_t length ) -> void
+{
+    while ( length >= 255 )
+    {
+        out.push_back( std::byte( 255 ) );
+        length -= 255;
+    }
+    out.push_back( std::byte( length ) );
+}
+
+static auto readLength ( const std::vector< std::byte > &in, size_t &pos ) -> size_t
+{
+    size_t length = 0;
+    while ( true )
+    {
+        if ( pos >= in.size() )
+        {
+            throw std::runtime_error( "Compressed block is truncated" );
+        }
+        auto value = std::to_integer< size_t >( in[pos++] );
+        length += value;
+        if ( value != 255 )
+        {
+            return length;
+        }
+    }
+}
+
+// token holds the literal length in the high nibble and the match length in the low nibble
+static auto writeSequence ( std::vector< std::byte > &out, const std::byte *literals, size_t literalLength, size_t offset, size_t matchLength ) -> void
+{
+    size_t extraMatch = matchLength >= MIN_MATCH ? matchLength - MIN_MATCH : 0;
+    auto token = ( std::min< size_t >( literalLength, 15 ) << 4 ) | std::min< size_t >( extraMatch, 15 );
+    out.push_back( std::byte( token ) );
+    if ( literalLength >= 15 )
+    {
+        writeLength( out, literalLength - 15 );
+    }
+    out.insert( out.end(), literals, literals + literalLength );
+    if ( matchLength == 0 )
+    {
+        return;
+    }
+    out.push_back( std::byte( offset & 0xFF ) );
+    out.push_back( std::byte( offset >> 8 ) );
+    if ( extraMatch >= 15 )
+    {
+        writeLength( out, extraMatch - 15 );
+    }
+}
+
+auto compressBlock ( const std::vector< std::byte > &data ) -> std::vector< std::byte >
+{
+    std::vector< std::byte > out;
+    out.reserve( data.size() / 2 );
+    std::vector< uint32_t > table( 1 << HASH_BITS, UINT32_MAX );
+
+    const std::byte *in = data.data();
+    size_t size = data.size(), anchor = 0, pos = 0;
+    while ( pos + MIN_MATCH <= size )
+    {
+        uint32_t value = read32( in + pos );
+        uint32_t hash = ( value * 2654435761U ) >> ( 32 - HASH_BITS );
+        uint32_t candidate = table[hash];
+        table[hash] = pos;
+
+        if ( candidate != UINT32_MAX && pos - candidate <= MAX_OFFSET && read32( in + candidate ) == value )
+        {
+            size_t length = MIN_MATCH;
+            while ( pos + length < size && in[candidate + length] == in[pos + length] )
+            {
+                ++length;
+            }
+            writeSequence( out, in + anchor, pos - anchor, pos - candidate, length );
+            pos += length;
+            anchor = pos;
+        }
+        else
+        {
+            ++pos;
+        }
+    }
+    writeSequence( out, in + anchor, size - anchor, 0, 0 );
+    return out;
+}
+
+auto decompressBlock ( const std::vector< std::byte > &data, storage_t size ) -> std::vector< std::byte >
+{
+    std::vector< std::byte > out( size );
+    size_t in = 0, pos = 0;
+    while ( in < data.size() )
+    {
+        auto token = std::to_integer< size_t >( data[in++] );
+
+        size_t literalLength = token >> 4;
+        if ( literalLength == 15 )
+        {
+            literalLength += readLength( data, in );
+        }
+        if ( in + literalLength > data.size() || pos + literalLength > size )
+        {
+            throw std::runtime_error( "Compressed block is corrupted" );
+        }
+        std::copy( data.begin() + in, data.begin() + in + literalLength, out.begin() + pos );
+        in += literalLength;
+        pos += literalLength;
+
+        // the last sequence carries literals only
+        if ( in >= data.size() )
+        {
+            break;
+        }
+
+        if ( in + 2 > data.size() )
+        {
+            throw std::runtime_error( "Compressed block is truncated" );
+        }
+        size_t offset = std::to_integer< size_t >( data[in] ) | ( std::to_integer< size_t >( data[in + 1] ) << 8 );
+        in += 2;
+        size_t matchLength = token & 0x0F;
+        if ( matchLength == 15 )
+        {
+            matchLength += readLength( data, in );
+        }
+        matchLength += MIN_MATCH;
+        if ( offset == 0 || offset > pos || pos + matchLength > size )
+        {
+            throw std::runtime_error( "Compressed block is corrupted" );
+        }
+
+        // byte by byte, a match may overlap the bytes it produces
+        for ( size_t i = 0; i < matchLength; ++i, ++pos )
+        {
+            out[pos] = out[pos - offset];
+        }
+    }
+    if ( pos != size )
+    {
+        throw std::runtime_error( "Compressed block has the wrong size" );
+    }
+    return out;
+}
+
+CompressedTier::CompressedTier ( storage_t _capacity, storage_t _pageSize )
+    : capacity( _capacity ), usedBytes( 0 ), pageSize( _pageSize )
+{
+}
+
+auto CompressedTier::drop ( decltype( pages )::iterator it ) -> void
+{
+    usedBytes -= it->second.first.size();
+    order.erase( it->second.second );
+    pages.erase( it );
+}
+
+auto CompressedTier::put ( page_id_t pageNumber, const std::vector< std::byte > &data ) -> void
+{
+    erase( pageNumber );
+
+    auto compressed = compressBlock( data );
+    if ( compressed.size() > pageSize * 3 / 4 || compressed.size() > capacity )
+    {
+        return;
+    }
+    while ( usedBytes + compressed.size() > capacity )
+    {
+        drop( pages.find( order.front() ) );
+    }
+
+    usedBytes += compressed.size();
+    order.push_back( pageNumber );
+    pages.emplace( pageNumber, std::make_pair( std::move( compressed ), std::prev( order.end() ) ) );
+}
+
+auto CompressedTier::take ( page_id_t pageNumber ) -> std::optional< std::vector< std::byte > >
+{
+    auto it = pages.find( pageNumber );
+    if ( it == pages.end() )
+    {
+        return std::nullopt;
+    }
+    auto data = decompressBlock( it->second.first, pageSize );
+    drop( it );
+    return data;
+}
+
+auto CompressedTier::erase ( page_id_t pageNumber ) -> void
+{
+    auto it = pages.find( pageNumber );
+    if ( it != pages.end() )
+    {
+        drop( it );
+    }
+}
+
+auto CompressedTier::clear ( ) -> void
+{
+    pages.clear();
+    order.clear();
+    usedBytes = 0;
+}
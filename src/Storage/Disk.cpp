@@ -72,3 +72,24 @@ auto Disk::writeBlock ( block_id_t blockNumber, const std::vector< std::byte > &
     diskFileStream.seekp( blockNumber * blockSize, std::ios::beg );
     diskFileStream.write( reinterpret_cast< const char * >( data.data() ), blockSize );
 }
+
+auto Disk::writeBlocks ( block_id_t firstBlock, std::span< const std::byte > data ) -> void
+{
+    size_t count = data.size() / blockSize;
+    if ( data.size() % blockSize != 0 )
+    {
+        throw std::invalid_argument( "Data is not a whole number of blocks" );
+    }
+    if ( firstBlock + count > blockCount )
+    {
+        throw std::out_of_range( "Block number out of range" );
+    }
+
+    // one seek for the whole run, then every block is transferred in order
+    if( accessType == SEQUENTIAL ) costIO += (firstBlock - diskFileStream.tellp() / blockSize + blockCount) % blockCount;
+    costIO += count;
+    numIO += count;
+
+    diskFileStream.seekp( firstBlock * blockSize, std::ios::beg );
+    diskFileStream.write( reinterpret_cast< const char * >( data.data() ), data.size() );
+}
@@ -0,0 +1,281 @@
+#include <Storage/HeapFile.hpp>
+#include <cstring>
+
+// identifies an initialised heap file header page
+static constexpr uint64_t HEAP_MAGIC = 0x48454150464C4531ULL;
+
+template < typename T >
+static auto readAt ( const std::vector< std::byte > &data, storage_t offset ) -> T
+{
+    T value;
+    std::memcpy( &value, data.data() + offset, sizeof( T ) );
+    return value;
+}
+
+template < typename T >
+static auto writeAt ( std::vector< std::byte > &data, storage_t offset, const T &value ) -> void
+{
+    std::memcpy( data.data() + offset, &value, sizeof( T ) );
+}
+
+HeapFile::HeapFile ( BufferManager *_bm, Extent _extent, bool create )
+    : buffer_manager( _bm ), extent( _extent ), pageSize( _bm->getBlockSize() ), numPages( 0 )
+{
+    if ( extent.size < 2 * pageSize )
+    {
+        throw std::runtime_error( "Extent too small for a heap file" );
+    }
+    // a released extent keeps its old header, so a new file never trusts what it finds there
+    if ( create )
+    {
+        saveHeader();
+        return;
+    }
+    auto header = readAt< FileHeader >( buffer_manager->readAddress( extent.start, sizeof( FileHeader ) ), 0 );
+    if ( header.magic != HEAP_MAGIC )
+    {
+        throw std::runtime_error( "Extent holds no heap file" );
+    }
+    if ( header.numPages > extent.size / pageSize - 1 )
+    {
+        throw std::runtime_error( "Heap file header is corrupt" );
+    }
+    numPages = header.numPages;
+    freeSpace.assign( numPages, 0 );
+    if ( numPages > 0 )
+    {
+        freeSpace.back() = pageFreeSpace( loadPage( numPages - 1 ) );
+    }
+}
+
+auto HeapFile::loadPage ( page_id_t page ) -> std::vector< std::byte >
+{
+    return buffer_manager->readAddress( pageAddress( page ), pageSize );
+}
+
+auto HeapFile::savePage ( page_id_t page, const std::vector< std::byte > &data ) -> void
+{
+    buffer_manager->writeAddress( pageAddress( page ), data );
+    freeSpace[page] = pageFreeSpace( data );
+}
+
+auto HeapFile::saveHeader ( ) -> void
+{
+    FileHeader header{ HEAP_MAGIC, numPages };
+    std::vector< std::byte > data( sizeof( header ) );
+    writeAt( data, 0, header );
+    buffer_manager->writeAddress( extent.start, data );
+}
+
+auto HeapFile::pageFreeSpace ( const std::vector< std::byte > &data ) const -> storage_t
+{
+    auto header = readAt< PageHeader >( data, 0 );
+    storage_t live = 0;
+    bool emptySlot = false;
+    for ( uint32_t i = 0; i < header.slotCount; ++i )
+    {
+        auto slot = readAt< Slot >( data, sizeof( PageHeader ) + i * sizeof( Slot ) );
+        live += slot.length;
+        emptySlot |= ( slot.length == 0 );
+    }
+    storage_t directory = sizeof( PageHeader ) + header.slotCount * sizeof( Slot );
+    storage_t available = pageSize - directory - live;
+    // a new tuple needs a new slot unless an empty one can be reused
+    if ( emptySlot )
+    {
+        return available;
+    }
+    return available >= sizeof( Slot ) ? available - sizeof( Slot ) : 0;
+}
+
+auto HeapFile::compact ( std::vector< std::byte > &data ) const -> void
+{
+    auto header = readAt< PageHeader >( data, 0 );
+    std::vector< std::byte > tuples( pageSize );
+    uint32_t end = pageSize;
+    for ( uint32_t i = 0; i < header.slotCount; ++i )
+    {
+        storage_t slotOffset = sizeof( PageHeader ) + i * sizeof( Slot );
+        auto slot = readAt< Slot >( data, slotOffset );
+        if ( slot.length == 0 )
+        {
+            continue;
+        }
+        end -= slot.length;
+        std::memcpy( tuples.data() + end, data.data() + slot.offset, slot.length );
+        slot.offset = end;
+        writeAt( data, slotOffset, slot );
+    }
+    std::memcpy( data.data() + end, tuples.data() + end, pageSize - end );
+    header.dataStart = end;
+    writeAt( data, 0, header );
+}
+
+auto HeapFile::placeTuple ( std::vector< std::byte > &data, uint32_t slot, std::span< const std::byte > tuple ) const -> void
+{
+    auto header = readAt< PageHeader >( data, 0 );
+    storage_t directoryEnd = sizeof( PageHeader ) + std::max( header.slotCount, slot + 1 ) * sizeof( Slot );
+    if ( header.dataStart < directoryEnd + tuple.size() )
+    {
+        // free space is fragmented by deleted or shrunk tuples
+        compact( data );
+        header = readAt< PageHeader >( data, 0 );
+    }
+    header.dataStart -= tuple.size();
+    header.slotCount = std::max( header.slotCount, slot + 1 );
+    std::memcpy( data.data() + header.dataStart, tuple.data(), tuple.size() );
+    writeAt( data, sizeof( PageHeader ) + slot * sizeof( Slot ), Slot{ header.dataStart, static_cast< uint32_t >( tuple.size() ) } );
+    writeAt( data, 0, header );
+}
+
+auto HeapFile::insert ( std::span< const std::byte > tuple ) -> std::optional< RecordId >
+{
+    if ( tuple.empty() || tuple.size() > getMaxTupleSize() )
+    {
+        return std::nullopt;
+    }
+
+    // newest page first, it is the one most likely to have room
+    std::optional< page_id_t > target;
+    if ( numPages > 0 && freeSpace.back() >= tuple.size() )
+    {
+        target = numPages - 1;
+    }
+    for ( page_id_t page = 0; !target.has_value() && page < numPages; ++page )
+    {
+        if ( freeSpace[page] >= tuple.size() )
+        {
+            target = page;
+        }
+    }
+
+    std::vector< std::byte > data;
+    if ( target.has_value() )
+    {
+        data = loadPage( target.value() );
+    }
+    else
+    {
+        if ( pageAddress( numPages + 1 ) > extent.end() )
+        {
+            return std::nullopt;
+        }
+        target = numPages++;
+        freeSpace.push_back( 0 );
+        data.assign( pageSize, std::byte( 0 ) );
+        writeAt( data, 0, PageHeader{ 0, static_cast< uint32_t >( pageSize ) } );
+        saveHeader();
+    }
+
+    auto header = readAt< PageHeader >( data, 0 );
+    uint32_t slot = header.slotCount;
+    for ( uint32_t i = 0; i < header.slotCount; ++i )
+    {
+        if ( readAt< Slot >( data, sizeof( PageHeader ) + i * sizeof( Slot ) ).length == 0 )
+        {
+            slot = i;
+            break;
+        }
+    }
+    placeTuple( data, slot, tuple );
+    savePage( target.value(), data );
+    return RecordId{ target.value(), slot };
+}
+
+auto HeapFile::read ( RecordId rid ) -> std::optional< std::vector< std::byte > >
+{
+    if ( rid.page >= numPages )
+    {
+        return std::nullopt;
+    }
+    auto data = loadPage( rid.page );
+    auto header = readAt< PageHeader >( data, 0 );
+    if ( rid.slot >= header.slotCount )
+    {
+        return std::nullopt;
+    }
+    auto slot = readAt< Slot >( data, sizeof( PageHeader ) + rid.slot * sizeof( Slot ) );
+    if ( slot.length == 0 )
+    {
+        return std::nullopt;
+    }
+    return std::vector< std::byte >( data.begin() + slot.offset, data.begin() + slot.offset + slot.length );
+}
+
+auto HeapFile::update ( RecordId rid, std::span< const std::byte > tuple ) -> bool
+{
+    if ( rid.page >= numPages || tuple.empty() )
+    {
+        return false;
+    }
+    auto data = loadPage( rid.page );
+    auto header = readAt< PageHeader >( data, 0 );
+    if ( rid.slot >= header.slotCount )
+    {
+        return false;
+    }
+    storage_t slotOffset = sizeof( PageHeader ) + rid.slot * sizeof( Slot );
+    auto slot = readAt< Slot >( data, slotOffset );
+    if ( slot.length == 0 )
+    {
+        return false;
+    }
+
+    if ( tuple.size() <= slot.length )
+    {
+        std::memcpy( data.data() + slot.offset, tuple.data(), tuple.size() );
+        slot.length = tuple.size();
+        writeAt( data, slotOffset, slot );
+    }
+    else
+    {
+        // the old tuple's space counts as free once the slot is emptied
+        writeAt( data, slotOffset, Slot{ 0, 0 } );
+        if ( pageFreeSpace( data ) < tuple.size() )
+        {
+            return false;
+        }
+        placeTuple( data, rid.slot, tuple );
+    }
+    savePage( rid.page, data );
+    return true;
+}
+
+auto HeapFile::remove ( RecordId rid ) -> bool
+{
+    if ( rid.page >= numPages )
+    {
+        return false;
+    }
+    auto data = loadPage( rid.page );
+    auto header = readAt< PageHeader >( data, 0 );
+    if ( rid.slot >= header.slotCount )
+    {
+        return false;
+    }
+    storage_t slotOffset = sizeof( PageHeader ) + rid.slot * sizeof( Slot );
+    if ( readAt< Slot >( data, slotOffset ).length == 0 )
+    {
+        return false;
+    }
+    writeAt( data, slotOffset, Slot{ 0, 0 } );
+    savePage( rid.page, data );
+    return true;
+}
+
+auto HeapFile::scan ( const std::function< void ( RecordId, std::span< const std::byte > ) > &visit ) -> void
+{
+    for ( page_id_t page = 0; page < numPages; ++page )
+    {
+        auto data = loadPage( page );
+        auto header = readAt< PageHeader >( data, 0 );
+        for ( uint32_t i = 0; i < header.slotCount; ++i )
+        {
+            auto slot = readAt< Slot >( data, sizeof( PageHeader ) + i * sizeof( Slot ) );
+            if ( slot.length > 0 )
+            {
+                visit( RecordId{ page, i }, std::span< const std::byte >( data.data() + slot.offset, slot.length ) );
+            }
+        }
+    }
+}
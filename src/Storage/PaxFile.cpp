@@ -0,0 +1,149 @@
+#include <Storage/PaxFile.hpp>
+#include <cstring>
+#include <cstddef>
+
+// identifies an initialised PAX file header page
+static constexpr uint64_t PAX_MAGIC = 0x504158464C453031ULL;
+
+template<typename T>
+auto PaxFile<T>::getColumns ( ) -> std::vector< PaxColumn >
+{
+    std::vector< PaxColumn > columns;
+    for ( const auto &field : fieldInfos< T >() )
+    {
+        columns.push_back( { field.offset, field.width } );
+    }
+    return columns;
+}
+
+template<typename T>
+auto PaxFile<T>::requiredSize ( size_t numRecords, storage_t pageSize ) -> storage_t
+{
+    storage_t width = 0;
+    for ( const auto &column : getColumns() )
+    {
+        width += column.width;
+    }
+    size_t perPage = ( pageSize - sizeof( PageHeader ) ) / width;
+    return ( ( numRecords + perPage - 1 ) / perPage + 1 ) * pageSize;
+}
+
+template<typename T>
+PaxFile<T>::PaxFile ( BufferManager *_bm, Extent _extent, bool create )
+    : buffer_manager( _bm ), extent( _extent ), pageSize( _bm->getBlockSize() ), columns( getColumns() ), numRecords( 0 )
+{
+    storage_t width = 0;
+    for ( const auto &column : columns )
+    {
+        width += column.width;
+    }
+    capacity = ( pageSize - sizeof( PageHeader ) ) / width;
+    if ( capacity == 0 || extent.size < 2 * pageSize )
+    {
+        throw std::runtime_error( "Extent too small for a PAX file" );
+    }
+
+    // a released extent keeps its old header, so a new file never trusts what it finds there
+    if ( create )
+    {
+        saveHeader();
+        return;
+    }
+    FileHeader header;
+    auto data = buffer_manager->readAddress( extent.start, sizeof( header ) );
+    std::memcpy( &header, data.data(), sizeof( header ) );
+    if ( header.magic != PAX_MAGIC )
+    {
+        throw std::runtime_error( "Extent holds no PAX file" );
+    }
+    if ( header.numRecords > ( extent.size / pageSize - 1 ) * capacity )
+    {
+        throw std::runtime_error( "PAX file header is corrupt" );
+    }
+    numRecords = header.numRecords;
+}
+
+template<typename T>
+PaxFile<T>::~PaxFile ( )
+{
+    saveHeader();
+}
+
+template<typename T>
+auto PaxFile<T>::columnOffset ( size_t column ) const -> storage_t
+{
+    storage_t offset = sizeof( PageHeader );
+    for ( size_t i = 0; i < column; ++i )
+    {
+        offset += columns[i].width * capacity;
+    }
+    return offset;
+}
+
+template<typename T>
+auto PaxFile<T>::saveHeader ( ) -> void
+{
+    FileHeader header{ PAX_MAGIC, numRecords };
+    std::vector< std::byte > data( sizeof( header ) );
+    std::memcpy( data.data(), &header, sizeof( header ) );
+    buffer_manager->writeAddress( extent.start, data );
+}
+
+template<typename T>
+auto PaxFile<T>::append ( const T &record ) -> std::optional< RecordId >
+{
+    RecordId rid{ numRecords / capacity, static_cast< uint32_t >( numRecords % capacity ) };
+    if ( ( diskPage( rid.page ) + 1 ) * pageSize > extent.end() )
+    {
+        return std::nullopt;
+    }
+
+    auto page = buffer_manager->pinPage( diskPage( rid.page ) );
+    std::byte *data = page.mutableData();
+    PageHeader header{ rid.slot + 1, 0 };
+    std::memcpy( data, &header, sizeof( header ) );
+    auto bytes = reinterpret_cast< const std::byte * >( &record );
+    for ( size_t i = 0; i < columns.size(); ++i )
+    {
+        std::memcpy( data + columnOffset( i ) + rid.slot * columns[i].width, bytes + columns[i].offset, columns[i].width );
+    }
+    ++numRecords;
+    return rid;
+}
+
+template<typename T>
+auto PaxFile<T>::get ( RecordId rid ) -> std::optional< T >
+{
+    if ( rid.slot >= capacity || rid.page * capacity + rid.slot >= numRecords )
+    {
+        return std::nullopt;
+    }
+    auto page = buffer_manager->pinPage( diskPage( rid.page ) );
+    T record{};
+    auto bytes = reinterpret_cast< std::byte * >( &record );
+    for ( size_t i = 0; i < columns.size(); ++i )
+    {
+        std::memcpy( bytes + columns[i].offset, page.data() + columnOffset( i ) + rid.slot * columns[i].width, columns[i].width );
+    }
+    return record;
+}
+
+template<typename T>
+auto PaxFile<T>::scanColumn ( size_t column, const std::function< void ( page_id_t, const std::byte *, size_t ) > &visit ) -> void
+{
+    if ( column >= columns.size() )
+    {
+        throw std::out_of_range( "Column index out of range" );
+    }
+    storage_t offset = columnOffset( column );
+    page_id_t numPages = ( numRecords + capacity - 1 ) / capacity;
+    for ( page_id_t i = 0; i < numPages; ++i )
+    {
+        auto page = buffer_manager->pinPage( diskPage( i ) );
+        size_t count = std::min< uint64_t >( capacity, numRecords - i * capacity );
+        visit( i, page.data() + offset, count );
+    }
+}
+
+template class PaxFile<Employee>;
+template class PaxFile<Company>;
@@ -0,0 +1,149 @@
+#include <Storage/SpaceManager.hpp>
+#include <cstring>
+#include <cstdint>
+
+// marks a disk whose tail holds an allocation map
+static constexpr uint64_t SPACE_MAGIC = 0x5350414345424D50ULL;
+
+// magic and block count stored before the bitmap
+static constexpr storage_t HEADER_SIZE = sizeof( uint64_t ) * 2;
+
+SpaceManager::SpaceManager ( BufferManager *_bm )
+    : buffer_manager( _bm ),
+      blockSize( _bm->getBlockSize() ),
+      blockCount( _bm->getBlockCount() ),
+      metaBlocks( ( HEADER_SIZE + ( blockCount + 7 ) / 8 + blockSize - 1 ) / blockSize ),
+      used( blockCount, false ),
+      dirty( false )
+{
+    if ( metaBlocks >= blockCount )
+    {
+        throw std::runtime_error( "Disk too small for an allocation map" );
+    }
+
+    auto data = buffer_manager->readAddress( metaAddress(), HEADER_SIZE + ( blockCount + 7 ) / 8 );
+    uint64_t magic, count;
+    std::memcpy( &magic, data.data(), sizeof( magic ) );
+    std::memcpy( &count, data.data() + sizeof( magic ), sizeof( count ) );
+    if ( magic != SPACE_MAGIC || count != blockCount )
+    {
+        format();
+        return;
+    }
+
+    for ( size_t i = 0; i < blockCount; ++i )
+    {
+        used[i] = ( std::to_integer< int >( data[HEADER_SIZE + i / 8] ) >> ( i % 8 ) ) & 1;
+    }
+}
+
+SpaceManager::~SpaceManager ( )
+{
+    sync();
+}
+
+auto SpaceManager::mark ( block_id_t first, size_t count, bool value ) -> void
+{
+    std::fill( used.begin() + first, used.begin() + first + count, value );
+    dirty = true;
+}
+
+auto SpaceManager::allocate ( storage_t size ) -> std::optional< Extent >
+{
+    size_t needed = std::max< size_t >( 1, ( size + blockSize - 1 ) / blockSize );
+    size_t runStart = 0, runLength = 0;
+    for ( size_t i = 0; i < blockCount; ++i )
+    {
+        if ( used[i] )
+        {
+            runLength = 0;
+            continue;
+        }
+        if ( runLength == 0 )
+        {
+            runStart = i;
+        }
+        if ( ++runLength == needed )
+        {
+            mark( runStart, needed, true );
+            return Extent{ runStart * blockSize, needed * blockSize };
+        }
+    }
+    return std::nullopt;
+}
+
+auto SpaceManager::allocateLargest ( ) -> std::optional< Extent >
+{
+    size_t bestStart = 0, bestLength = 0, runStart = 0, runLength = 0;
+    for ( size_t i = 0; i < blockCount; ++i )
+    {
+        if ( used[i] )
+        {
+            runLength = 0;
+            continue;
+        }
+        if ( runLength == 0 )
+        {
+            runStart = i;
+        }
+        if ( ++runLength > bestLength )
+        {
+            bestStart = runStart;
+            bestLength = runLength;
+        }
+    }
+    if ( bestLength == 0 )
+    {
+        return std::nullopt;
+    }
+    mark( bestStart, bestLength, true );
+    return Extent{ bestStart * blockSize, bestLength * blockSize };
+}
+
+auto SpaceManager::shrink ( Extent &extent, storage_t size ) -> void
+{
+    storage_t keep = std::max< storage_t >( 1, ( size + blockSize - 1 ) / blockSize ) * blockSize;
+    if ( keep >= extent.size )
+    {
+        return;
+    }
+    mark( ( extent.start + keep ) / blockSize, ( extent.size - keep ) / blockSize, false );
+    extent.size = keep;
+}
+
+auto SpaceManager::release ( const Extent &extent ) -> void
+{
+    mark( extent.start / blockSize, extent.size / blockSize, false );
+}
+
+auto SpaceManager::format ( ) -> void
+{
+    mark( 0, blockCount, false );
+    mark( blockCount - metaBlocks, metaBlocks, true );
+}
+
+auto SpaceManager::sync ( ) -> void
+{
+    if ( !dirty )
+    {
+        return;
+    }
+    std::vector< std::byte > data( HEADER_SIZE + ( blockCount + 7 ) / 8, std::byte( 0 ) );
+    uint64_t magic = SPACE_MAGIC, count = blockCount;
+    std::memcpy( data.data(), &magic, sizeof( magic ) );
+    std::memcpy( data.data() + sizeof( magic ), &count, sizeof( count ) );
+    for ( size_t i = 0; i < blockCount; ++i )
+    {
+        if ( used[i] )
+        {
+            data[HEADER_SIZE + i / 8] |= std::byte( 1 << ( i % 8 ) );
+        }
+    }
+    buffer_manager->writeAddress( metaAddress(), data );
+    dirty = false;
+}
+
+auto SpaceManager::getFreeBlocks ( ) const -> size_t
+{
+    return std::count( used.begin(), used.end(), false );
+}
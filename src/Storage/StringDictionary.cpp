@@ -0,0 +1,116 @@
+#include <Storage/StringDictionary.hpp>
+#include <cstring>
+
+// identifies an initialised dictionary header page
+static constexpr uint64_t DICTIONARY_MAGIC = 0x44494354494F4E31ULL;
+
+StringDictionary::StringDictionary ( BufferManager *_bm, Extent _extent, bool create )
+    : buffer_manager( _bm ), extent( _extent ), pageSize( _bm->getBlockSize() ), bytes( 0 ), savedBytes( 0 ), savedCount( 0 )
+{
+    if ( extent.size < 2 * pageSize )
+    {
+        throw std::runtime_error( "Extent too small for a dictionary" );
+    }
+    // a released extent keeps its old header, so a new dictionary never trusts what it finds there
+    if ( create )
+    {
+        save();
+        return;
+    }
+    Header header;
+    auto data = buffer_manager->readAddress( extent.start, sizeof( Header ) );
+    std::memcpy( &header, data.data(), sizeof( Header ) );
+    if ( header.magic != DICTIONARY_MAGIC )
+    {
+        throw std::runtime_error( "Extent holds no dictionary" );
+    }
+    if ( header.bytes > extent.size - pageSize )
+    {
+        throw std::runtime_error( "Dictionary header is corrupt" );
+    }
+
+    auto entries = buffer_manager->readAddress( extent.start + pageSize, header.bytes );
+    for ( storage_t offset = 0; offset < header.bytes && values.size() < header.count; )
+    {
+        size_t length = std::to_integer< size_t >( entries[offset] );
+        if ( offset + 1 + length > header.bytes )
+        {
+            throw std::runtime_error( "Dictionary entry is truncated" );
+        }
+        values.emplace_back( reinterpret_cast< const char * >( entries.data() + offset + 1 ), length );
+        codes.emplace( values.back(), values.size() - 1 );
+        offset += 1 + length;
+    }
+    if ( values.size() != header.count )
+    {
+        throw std::runtime_error( "Dictionary entry is truncated" );
+    }
+    bytes = savedBytes = header.bytes;
+    savedCount = header.count;
+}
+
+StringDictionary::~StringDictionary ( )
+{
+    save();
+}
+
+auto StringDictionary::encode ( std::string_view value ) -> uint32_t
+{
+    auto it = codes.find( std::string( value ) );
+    if ( it != codes.end() )
+    {
+        return it->second;
+    }
+    if ( value.size() > 255 )
+    {
+        throw std::invalid_argument( "Dictionary entries are at most 255 bytes" );
+    }
+    if ( bytes + 1 + value.size() > extent.size - pageSize )
+    {
+        throw std::runtime_error( "Dictionary extent is full" );
+    }
+    values.emplace_back( value );
+    codes.emplace( values.back(), values.size() - 1 );
+    bytes += 1 + value.size();
+    return values.size() - 1;
+}
+
+auto StringDictionary::find ( std::string_view value ) const -> std::optional< uint32_t >
+{
+    auto it = codes.find( std::string( value ) );
+    if ( it == codes.end() )
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+auto StringDictionary::decode ( uint32_t code ) const -> std::string_view
+{
+    if ( code >= values.size() )
+    {
+        throw std::out_of_range( "Dictionary code out of range" );
+    }
+    return values[code];
+}
+
+auto StringDictionary::save ( ) -> void
+{
+    // entries are append only, so only the tail written since the last save goes to the disk
+    if ( savedCount < values.size() )
+    {
+        std::vector< std::byte > tail;
+        tail.reserve( bytes - savedBytes );
+        for ( size_t i = savedCount; i < values.size(); ++i )
+        {
+            tail.push_back( std::byte( values[i].size() ) );
+            auto characters = reinterpret_cast< const std::byte * >( values[i].data() );
+            tail.insert( tail.end(), characters, characters + values[i].size() );
+        }
+        buffer_manager->writeAddress( extent.start + pageSize + savedBytes, tail );
+    }
+    Header header{ DICTIONARY_MAGIC, values.size(), bytes };
+    buffer_manager->writeAddress( extent.start, std::span< const std::byte >( reinterpret_cast< const std::byte * >( &header ), sizeof( header ) ) );
+    savedBytes = bytes;
+    savedCount = values.size();
+}
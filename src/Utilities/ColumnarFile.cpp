@@ -0,0 +1,385 @@
+#include <Utilities/ColumnarFile.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Writes a signed integer field of 1, 2, 4 or 8 bytes
+static auto writeInteger(std::byte *field, size_t width, int64_t value) -> void
+{
+    switch (width)
+    {
+    case 1: { int8_t v = value; std::memcpy(field, &v, 1); return; }
+    case 2: { int16_t v = value; std::memcpy(field, &v, 2); return; }
+    case 4: { int32_t v = value; std::memcpy(field, &v, 4); return; }
+    case 8: { std::memcpy(field, &value, 8); return; }
+    }
+    throw std::invalid_argument("Unsupported integer width");
+}
+
+// Appends a signed value as a zigzag LEB128 varint
+static auto appendVarint(std::vector<std::byte> &out, int64_t value) -> void
+{
+    uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    while (zigzag >= 0x80)
+    {
+        out.push_back(std::byte((zigzag & 0x7F) | 0x80));
+        zigzag >>= 7;
+    }
+    out.push_back(std::byte(zigzag));
+}
+
+// Reads a zigzag LEB128 varint, advancing `p`
+static auto takeVarint(const std::byte *&p, const std::byte *end) -> int64_t
+{
+    uint64_t zigzag = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (p == end)
+        {
+            throw std::runtime_error("Columnar chunk is truncated");
+        }
+        uint64_t byte = std::to_integer<uint64_t>(*p++);
+        zigzag |= (byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return static_cast<int64_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+        }
+    }
+    throw std::runtime_error("Columnar varint is too long");
+}
+
+// Tells whether a string column's dictionary lies before the footer with entry offsets that never go back
+static auto validDictionary(const std::byte *data, const ColumnarColumn &column, uint64_t footerOffset) -> bool
+{
+    if (column.dictOffset % alignof(uint32_t) != 0 || column.dictOffset > footerOffset ||
+        (column.dictCount + 1ull) * sizeof(uint32_t) > footerOffset - column.dictOffset)
+    {
+        return false;
+    }
+    auto offsets = reinterpret_cast<const uint32_t *>(data + column.dictOffset);
+    if (offsets[0] != 0)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < column.dictCount; ++i)
+    {
+        if (offsets[i + 1] < offsets[i])
+        {
+            return false;
+        }
+    }
+    // the characters follow the offsets and end before the footer
+    return offsets[column.dictCount] <= footerOffset - column.dictOffset - (column.dictCount + 1ull) * sizeof(uint32_t);
+}
+
+// Pads a stream position to 8 bytes
+static auto align8(std::ofstream &file, uint64_t &position) -> void
+{
+    static const char zeros[8] = {};
+    uint64_t padding = (8 - position % 8) % 8;
+    file.write(zeros, padding);
+    position += padding;
+}
+
+ColumnarWriter::ColumnarWriter(std::string _fileName, std::span<const FieldInfo> _fields, storage_t _recordSize)
+    : fileName(_fileName), fields(_fields.begin(), _fields.end()), recordSize(_recordSize), numRows(0),
+      values(_fields.size()), dictionaries(_fields.size()), dictionaryIndex(_fields.size()), finished(false)
+{
+    for (const auto &field : fields)
+    {
+        if (field.name.size() >= sizeof(ColumnarColumn::name))
+        {
+            throw std::invalid_argument("Field name is too long for a columnar file");
+        }
+    }
+}
+
+ColumnarWriter::~ColumnarWriter()
+{
+    if (!finished)
+    {
+        try
+        {
+            finish();
+        }
+        catch (...)
+        {
+        }
+    }
+}
+
+auto ColumnarWriter::append(const std::byte *record) -> void
+{
+    for (size_t c = 0; c < fields.size(); ++c)
+    {
+        const auto &field = fields[c];
+        if (field.kind == FieldKind::INTEGER)
+        {
+            values[c].push_back(readInteger(record + field.offset, field.width));
+        }
+        else
+        {
+            auto text = reinterpret_cast<const char *>(record + field.offset);
+            std::string value(text, strnlen(text, field.width));
+            auto [it, inserted] = dictionaryIndex[c].try_emplace(value, dictionaries[c].size());
+            if (inserted)
+            {
+                dictionaries[c].push_back(value);
+            }
+            values[c].push_back(it->second);
+        }
+    }
+    ++numRows;
+}
+
+auto ColumnarWriter::finish() -> void
+{
+    finished = true;
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Error opening file " + fileName);
+    }
+
+    // sort every dictionary so code order is string order, then renumber the values
+    std::vector<ColumnarColumn> columns(fields.size());
+    for (size_t c = 0; c < fields.size(); ++c)
+    {
+        auto &column = columns[c];
+        std::memset(&column, 0, sizeof(column));
+        std::copy(fields[c].name.begin(), fields[c].name.end(), column.name);
+        column.kind = static_cast<uint32_t>(fields[c].kind);
+        column.width = fields[c].width;
+        column.offset = fields[c].offset;
+        if (fields[c].kind != FieldKind::STRING)
+        {
+            continue;
+        }
+        auto &dictionary = dictionaries[c];
+        std::vector<uint32_t> order(dictionary.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&dictionary](uint32_t a, uint32_t b) { return dictionary[a] < dictionary[b]; });
+        std::vector<int64_t> code(dictionary.size());
+        std::vector<std::string> sorted(dictionary.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            code[order[i]] = i;
+            sorted[i] = std::move(dictionary[order[i]]);
+        }
+        dictionary = std::move(sorted);
+        for (auto &value : values[c])
+        {
+            value = code[value];
+        }
+        column.dictCount = dictionary.size();
+        column.codeWidth = dictionary.size() <= (1u << 8) ? 1 : dictionary.size() <= (1u << 16) ? 2 : 4;
+    }
+
+    // blocks, one chunk per column each
+    uint32_t numBlocks = (numRows + COLUMNAR_BLOCK_ROWS - 1) / COLUMNAR_BLOCK_ROWS;
+    std::vector<ColumnarChunk> chunks;
+    uint64_t position = 0;
+    std::vector<std::byte> encoded;
+    for (uint32_t block = 0; block < numBlocks; ++block)
+    {
+        size_t first = static_cast<size_t>(block) * COLUMNAR_BLOCK_ROWS;
+        size_t last = std::min<size_t>(first + COLUMNAR_BLOCK_ROWS, numRows);
+        for (size_t c = 0; c < fields.size(); ++c)
+        {
+            encoded.clear();
+            auto begin = values[c].begin() + first, end = values[c].begin() + last;
+            auto [min, max] = std::minmax_element(begin, end);
+            if (fields[c].kind == FieldKind::INTEGER)
+            {
+                int64_t previous = 0;
+                for (auto it = begin; it != end; ++it)
+                {
+                    appendVarint(encoded, static_cast<int64_t>(static_cast<uint64_t>(*it) - static_cast<uint64_t>(previous)));
+                    previous = *it;
+                }
+            }
+            else
+            {
+                encoded.resize((last - first) * columns[c].codeWidth);
+                for (auto it = begin; it != end; ++it)
+                {
+                    uint32_t code = *it;
+                    std::memcpy(encoded.data() + (it - begin) * columns[c].codeWidth, &code, columns[c].codeWidth);
+                }
+            }
+            chunks.push_back({position, encoded.size(), *min, *max});
+            file.write(reinterpret_cast<const char *>(encoded.data()), encoded.size());
+            position += encoded.size();
+        }
+    }
+
+    // dictionaries: entry offsets, then the characters
+    for (size_t c = 0; c < fields.size(); ++c)
+    {
+        if (fields[c].kind != FieldKind::STRING)
+        {
+            continue;
+        }
+        align8(file, position);
+        columns[c].dictOffset = position;
+        std::vector<uint32_t> offsets{0};
+        for (const auto &entry : dictionaries[c])
+        {
+            offsets.push_back(offsets.back() + entry.size());
+        }
+        file.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint32_t));
+        for (const auto &entry : dictionaries[c])
+        {
+            file.write(entry.data(), entry.size());
+        }
+        position += offsets.size() * sizeof(uint32_t) + offsets.back();
+    }
+
+    align8(file, position);
+    uint64_t footerOffset = position;
+    ColumnarFooter footer{COLUMNAR_MAGIC, numRows, recordSize, static_cast<uint32_t>(fields.size()), numBlocks};
+    file.write(reinterpret_cast<const char *>(&footer), sizeof(footer));
+    file.write(reinterpret_cast<const char *>(columns.data()), columns.size() * sizeof(ColumnarColumn));
+    file.write(reinterpret_cast<const char *>(chunks.data()), chunks.size() * sizeof(ColumnarChunk));
+    file.write(reinterpret_cast<const char *>(&footerOffset), sizeof(footerOffset));
+    file.write(reinterpret_cast<const char *>(&COLUMNAR_MAGIC), sizeof(COLUMNAR_MAGIC));
+    if (!file)
+    {
+        throw std::runtime_error("Error writing file " + fileName);
+    }
+
+    values.clear();
+    dictionaries.clear();
+    dictionaryIndex.clear();
+}
+
+ColumnarFile::ColumnarFile(const std::string &fileName)
+    : data(nullptr), size(0), footer(nullptr), columns(nullptr), chunks(nullptr)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Error opening file " + fileName);
+    }
+    struct stat info;
+    fstat(fd, &info);
+    size = info.st_size;
+    void *mapped = size >= 2 * sizeof(uint64_t) ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        throw std::runtime_error("Not a columnar file: " + fileName);
+    }
+    data = static_cast<const std::byte *>(mapped);
+
+    uint64_t tail[2];
+    std::memcpy(tail, data + size - sizeof(tail), sizeof(tail));
+    uint64_t footerOffset = tail[0];
+    bool valid = tail[1] == COLUMNAR_MAGIC && footerOffset % 8 == 0 && footerOffset + sizeof(ColumnarFooter) <= size - sizeof(tail);
+    if (valid)
+    {
+        footer = reinterpret_cast<const ColumnarFooter *>(data + footerOffset);
+        columns = reinterpret_cast<const ColumnarColumn *>(footer + 1);
+        chunks = reinterpret_cast<const ColumnarChunk *>(columns + footer->numColumns);
+        valid = footer->magic == COLUMNAR_MAGIC &&
+                reinterpret_cast<const std::byte *>(chunks + static_cast<size_t>(footer->numBlocks) * footer->numColumns) <= data + size - sizeof(tail) &&
+                static_cast<uint64_t>(footer->numBlocks) * COLUMNAR_BLOCK_ROWS >= footer->numRows;
+    }
+    for (uint32_t c = 0; valid && c < footer->numColumns; ++c)
+    {
+        valid = columns[c].offset + columns[c].width <= footer->recordSize && (columns[c].kind != static_cast<uint32_t>(FieldKind::STRING) ||
+                (columns[c].width > 0 && columns[c].codeWidth > 0 && columns[c].codeWidth <= sizeof(uint32_t) && validDictionary(data, columns[c], footerOffset)));
+    }
+    for (size_t i = 0; valid && i < static_cast<size_t>(footer->numBlocks) * footer->numColumns; ++i)
+    {
+        valid = chunks[i].offset + chunks[i].size <= footerOffset;
+    }
+    if (!valid)
+    {
+        munmap(const_cast<std::byte *>(data), size);
+        throw std::runtime_error("Not a columnar file: " + fileName);
+    }
+}
+
+ColumnarFile::~ColumnarFile()
+{
+    munmap(const_cast<std::byte *>(data), size);
+}
+
+auto ColumnarFile::decodeBlock(uint32_t block, std::byte *out) const -> size_t
+{
+    if (block >= footer->numBlocks)
+    {
+        throw std::out_of_range("Block number out of range");
+    }
+    size_t rows = std::min<uint64_t>(COLUMNAR_BLOCK_ROWS, footer->numRows - static_cast<uint64_t>(block) * COLUMNAR_BLOCK_ROWS);
+    std::memset(out, 0, rows * footer->recordSize);
+    for (uint32_t c = 0; c < footer->numColumns; ++c)
+    {
+        const auto &column = columns[c];
+        const auto &chunk = getChunk(block, c);
+        const std::byte *p = data + chunk.offset, *end = p + chunk.size;
+        std::byte *field = out + column.offset;
+        if (column.kind == static_cast<uint32_t>(FieldKind::INTEGER))
+        {
+            int64_t value = 0;
+            for (size_t r = 0; r < rows; ++r, field += footer->recordSize)
+            {
+                value = static_cast<int64_t>(static_cast<uint64_t>(value) + static_cast<uint64_t>(takeVarint(p, end)));
+                writeInteger(field, column.width, value);
+            }
+        }
+        else
+        {
+            if (chunk.size < rows * column.codeWidth)
+            {
+                throw std::runtime_error("Columnar chunk is truncated");
+            }
+            auto offsets = reinterpret_cast<const uint32_t *>(data + column.dictOffset);
+            auto characters = reinterpret_cast<const char *>(offsets + column.dictCount + 1);
+            for (size_t r = 0; r < rows; ++r, field += footer->recordSize)
+            {
+                uint32_t code = 0;
+                std::memcpy(&code, p + r * column.codeWidth, column.codeWidth);
+                if (code >= column.dictCount)
+                {
+                    throw std::runtime_error("Columnar dictionary code out of range");
+                }
+                // the record is zeroed, so a value filling the whole array needs no terminating NUL
+                size_t length = std::min<size_t>(offsets[code + 1] - offsets[code], column.width);
+                std::memcpy(field, characters + offsets[code], length);
+            }
+        }
+    }
+    return rows;
+}
+
+auto ColumnarFile::load(BufferManager &buffer, address_id_t start, std::span<const FieldInfo> fields) const -> address_id_t
+{
+    bool matches = fields.size() == footer->numColumns;
+    for (size_t c = 0; matches && c < fields.size(); ++c)
+    {
+        matches = fields[c].name == columns[c].name && static_cast<uint32_t>(fields[c].kind) == columns[c].kind &&
+                  fields[c].width == columns[c].width && fields[c].offset == columns[c].offset;
+    }
+    if (!matches)
+    {
+        throw std::runtime_error("Columnar file holds another record type");
+    }
+
+    std::vector<std::byte> records(COLUMNAR_BLOCK_ROWS * footer->recordSize);
+    address_id_t address = start;
+    for (uint32_t block = 0; block < footer->numBlocks; ++block)
+    {
+        size_t rows = decodeBlock(block, records.data());
+        bulkWrite(buffer, address, std::span<const std::byte>(records.data(), rows * footer->recordSize));
+        address += rows * footer->recordSize;
+    }
+    return address;
+}
@@ -0,0 +1,253 @@
+#include <Utilities/CsvConverter.hpp>
+#include <Utilities/TaskScheduler.hpp>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    #include <immintrin.h>
+#endif
+
+auto findByte(const char *begin, const char *end, char value) -> const char *
+{
+    const char *p = begin;
+#if defined(__AVX2__)
+    const __m256i needle = _mm256_set1_epi8(value);
+    for (; p + 32 <= end; p += 32)
+    {
+        auto mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), needle));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i needle16 = _mm_set1_epi8(value);
+    for (; p + 16 <= end; p += 16)
+    {
+        auto mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), needle16));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; p < end; ++p)
+    {
+        if (*p == value)
+        {
+            return p;
+        }
+    }
+    return end;
+}
+
+// Characters trimmed from both ends of a value
+static auto isTrimmed(char c) -> bool
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '"';
+}
+
+// End of the line starting at `begin`, without its line break
+static auto lineEnd(const char *begin, const char *eol) -> const char *
+{
+    return (eol > begin && eol[-1] == '\r') ? eol - 1 : eol;
+}
+
+// Counts the non-empty lines in [begin, end)
+static auto countRows(const char *begin, const char *end) -> size_t
+{
+    size_t rows = 0;
+    for (const char *p = begin; p < end;)
+    {
+        const char *eol = findByte(p, end, '\n');
+        rows += lineEnd(p, eol) > p;
+        p = eol + 1;
+    }
+    return rows;
+}
+
+// Parses one line into a zeroed record
+static auto parseRow(const char *begin, const char *end, char delim, std::span<const FieldInfo> fields, const std::vector<size_t> &columns, std::byte *record) -> void
+{
+    const char *p = begin;
+    for (size_t column = 0; column < columns.size() && p <= end; ++column)
+    {
+        const char *fieldEnd = findByte(p, end, delim);
+        if (columns[column] != SKIP_COLUMN)
+        {
+            const char *first = p, *last = fieldEnd;
+            while (first < last && isTrimmed(*first))
+            {
+                ++first;
+            }
+            while (last > first && isTrimmed(last[-1]))
+            {
+                --last;
+            }
+            const FieldInfo &field = fields[columns[column]];
+            if (field.kind == FieldKind::INTEGER)
+            {
+                long long value = 0;
+                auto [ptr, ec] = std::from_chars(first, last, value);
+                if (ec != std::errc() || (field.width == sizeof(int) && (value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max())))
+                {
+                    throw std::runtime_error("Invalid number in field " + std::string(field.name) + ": " + std::string(first, last));
+                }
+                if (field.width == sizeof(int))
+                {
+                    int narrow = static_cast<int>(value);
+                    std::memcpy(record + field.offset, &narrow, sizeof(narrow));
+                }
+                else
+                {
+                    std::memcpy(record + field.offset, &value, std::min<size_t>(field.width, sizeof(value)));
+                }
+            }
+            else
+            {
+                // the record is zeroed, so the string stays NUL terminated
+                std::memcpy(record + field.offset, first, std::min<size_t>(last - first, field.width - 1));
+            }
+        }
+        p = fieldEnd + 1;
+    }
+}
+
+auto convertCsv(const std::string &csvFile, const std::string &binFile, char delim, std::span<const FieldInfo> fields, storage_t recordSize, const std::vector<size_t> &columns, unsigned numThreads) -> size_t
+{
+    for (auto column : columns)
+    {
+        if (column != SKIP_COLUMN && column >= fields.size())
+        {
+            throw std::invalid_argument("Column mapped to an unknown field");
+        }
+    }
+    numThreads = std::max(numThreads, 1u);
+
+    int input = open(csvFile.c_str(), O_RDONLY);
+    if (input < 0)
+    {
+        throw std::runtime_error("Error opening file " + csvFile);
+    }
+    struct stat info;
+    fstat(input, &info);
+    size_t inputSize = info.st_size;
+    const char *text = nullptr;
+    if (inputSize > 0)
+    {
+        void *mapped = mmap(nullptr, inputSize, PROT_READ, MAP_PRIVATE, input, 0);
+        if (mapped == MAP_FAILED)
+        {
+            close(input);
+            throw std::runtime_error("Error mapping file " + csvFile);
+        }
+        text = static_cast<const char *>(mapped);
+        madvise(mapped, inputSize, MADV_SEQUENTIAL);
+    }
+    close(input);
+    const char *end = text + inputSize;
+
+    // skip the header, then cut the rest into one chunk per thread on line boundaries
+    const char *body = text ? std::min(end, findByte(text, end, '\n') + 1) : end;
+    std::vector<const char *> bounds{body};
+    for (unsigned i = 1; i < numThreads; ++i)
+    {
+        const char *target = body + (end - body) * i / numThreads;
+        bounds.push_back(target <= bounds.back() ? bounds.back() : std::min(end, findByte(target, end, '\n') + 1));
+    }
+    bounds.push_back(end);
+    size_t numChunks = bounds.size() - 1;
+
+    // every thread runs both passes on its chunk, the row counts give each chunk its place in the output
+    std::vector<size_t> firstRow(numChunks + 1, 0);
+    {
+        TaskGroup count;
+        for (size_t i = 0; i < numChunks; ++i)
+        {
+            count.run([&, i]() { firstRow[i + 1] = countRows(bounds[i], bounds[i + 1]); });
+        }
+        count.wait();
+    }
+    for (size_t i = 0; i < numChunks; ++i)
+    {
+        firstRow[i + 1] += firstRow[i];
+    }
+    size_t numRows = firstRow[numChunks];
+
+    int output = open(binFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (output < 0 || ftruncate(output, numRows * recordSize) != 0)
+    {
+        if (output >= 0)
+        {
+            close(output);
+        }
+        if (text)
+        {
+            munmap(const_cast<char *>(text), inputSize);
+        }
+        throw std::runtime_error("Error creating file " + binFile);
+    }
+    std::byte *records = nullptr;
+    if (numRows > 0)
+    {
+        void *mapped = mmap(nullptr, numRows * recordSize, PROT_READ | PROT_WRITE, MAP_SHARED, output, 0);
+        if (mapped == MAP_FAILED)
+        {
+            close(output);
+            munmap(const_cast<char *>(text), inputSize);
+            throw std::runtime_error("Error mapping file " + binFile);
+        }
+        records = static_cast<std::byte *>(mapped);
+    }
+    close(output);
+
+    // a failed chunk cancels the chunks that have not started, its exception is rethrown once the mappings are released
+    std::exception_ptr error;
+    TaskGroup parse;
+    for (size_t i = 0; i < numChunks; ++i)
+    {
+        parse.run([&, i]() {
+            std::byte *record = records + firstRow[i] * recordSize;
+            for (const char *p = bounds[i]; p < bounds[i + 1];)
+            {
+                const char *eol = findByte(p, bounds[i + 1], '\n');
+                const char *last = lineEnd(p, eol);
+                if (last > p)
+                {
+                    parseRow(p, last, delim, fields, columns, record);
+                    record += recordSize;
+                }
+                p = eol + 1;
+            }
+        });
+    }
+    try
+    {
+        parse.wait();
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    if (records)
+    {
+        munmap(records, numRows * recordSize);
+    }
+    if (text)
+    {
+        munmap(const_cast<char *>(text), inputSize);
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    return numRows;
+}
@@ -0,0 +1,87 @@
+#include <Utilities/KeySort.hpp>
+#include <array>
+#include <cstring>
+
+// Pairs in the write combining buffer of a bucket, one cache line
+static constexpr size_t COMBINE_ENTRIES = 64 / sizeof(KeyPointer);
+
+// Pairs read ahead of the one being counted
+static constexpr size_t PREFETCH_DISTANCE = 16;
+
+static constexpr size_t NUM_DIGITS = sizeof(uint64_t) * 8 / RADIX_BITS;
+
+static inline auto digitOf(uint64_t prefix, size_t digit) -> size_t
+{
+    return (prefix >> (digit * RADIX_BITS)) & (RADIX_BUCKETS - 1);
+}
+
+auto radixSortKeyPointers(std::vector<KeyPointer> &entries, std::vector<KeyPointer> &scratch) -> void
+{
+    const size_t count = entries.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    // histograms of every digit in a single read of the pairs
+    std::vector<std::array<size_t, RADIX_BUCKETS>> histograms(NUM_DIGITS);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i + PREFETCH_DISTANCE < count)
+        {
+            __builtin_prefetch(&entries[i + PREFETCH_DISTANCE]);
+        }
+        const uint64_t prefix = entries[i].prefix;
+        for (size_t digit = 0; digit < NUM_DIGITS; ++digit)
+        {
+            ++histograms[digit][digitOf(prefix, digit)];
+        }
+    }
+
+    scratch.resize(count);
+    KeyPointer *from = entries.data(), *to = scratch.data();
+    alignas(64) std::array<std::array<KeyPointer, COMBINE_ENTRIES>, RADIX_BUCKETS> combine;
+    std::array<size_t, RADIX_BUCKETS> offsets, filled;
+    for (size_t digit = 0; digit < NUM_DIGITS; ++digit)
+    {
+        const auto &histogram = histograms[digit];
+        // a digit every pair shares does not reorder anything
+        if (histogram[digitOf(from[0].prefix, digit)] == count)
+        {
+            continue;
+        }
+        size_t offset = 0;
+        for (size_t bucket = 0; bucket < RADIX_BUCKETS; ++bucket)
+        {
+            offsets[bucket] = offset;
+            offset += histogram[bucket];
+        }
+
+        // pairs gather in their bucket's buffer and go out a cache line at a time
+        filled.fill(0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i + PREFETCH_DISTANCE < count)
+            {
+                __builtin_prefetch(&from[i + PREFETCH_DISTANCE]);
+            }
+            const size_t bucket = digitOf(from[i].prefix, digit);
+            combine[bucket][filled[bucket]++] = from[i];
+            if (filled[bucket] == COMBINE_ENTRIES)
+            {
+                std::memcpy(to + offsets[bucket], combine[bucket].data(), sizeof(combine[bucket]));
+                offsets[bucket] += COMBINE_ENTRIES;
+                filled[bucket] = 0;
+            }
+        }
+        for (size_t bucket = 0; bucket < RADIX_BUCKETS; ++bucket)
+        {
+            std::memcpy(to + offsets[bucket], combine[bucket].data(), filled[bucket] * sizeof(KeyPointer));
+        }
+        std::swap(from, to);
+    }
+    if (from != entries.data())
+    {
+        entries.swap(scratch);
+    }
+}
@@ -0,0 +1,169 @@
+#include <Utilities/Predicate.hpp>
+#include <array>
+#include <limits>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define PREDICATE_X86 1
+    #include <immintrin.h>
+#endif
+
+using RangeKernel = auto (*)(const std::byte *, size_t, size_t, int32_t, int32_t, uint32_t *) -> size_t;
+
+// Value at a position, the column need not be aligned
+static inline auto valueAt(const std::byte *values, size_t stride, size_t i) -> int32_t
+{
+    int32_t value;
+    std::memcpy(&value, values + i * stride, sizeof(value));
+    return value;
+}
+
+// Positions are always written and only kept by advancing the count, so no branch depends on the values
+static auto scalarRange(const std::byte *values, size_t first, size_t count, size_t stride, int32_t low, int32_t high, uint32_t *selection, size_t selected) -> size_t
+{
+    for (size_t i = first; i < count; ++i)
+    {
+        int32_t value = valueAt(values, stride, i);
+        selection[selected] = static_cast<uint32_t>(i);
+        selected += (value >= low) & (value <= high);
+    }
+    return selected;
+}
+
+auto selectRangeScalar(const std::byte *values, size_t count, size_t stride, int32_t low, int32_t high, uint32_t *selection) -> size_t
+{
+    return scalarRange(values, 0, count, stride, low, high, selection, 0);
+}
+
+#if defined(PREDICATE_X86)
+
+// Lane permutation moving the lanes set in an 8 bit mask to the front
+static constexpr auto compactTable = [] {
+    std::array<std::array<int32_t, 8>, 256> table{};
+    for (int mask = 0; mask < 256; ++mask)
+    {
+        int next = 0;
+        for (int lane = 0; lane < 8; ++lane)
+        {
+            if (mask & (1 << lane))
+            {
+                table[mask][next++] = lane;
+            }
+        }
+    }
+    return table;
+}();
+
+__attribute__((target("avx2")))
+static auto avx2Range(const std::byte *values, size_t count, size_t stride, int32_t low, int32_t high, uint32_t *selection) -> size_t
+{
+    const __m256i lowVec = _mm256_set1_epi32(low);
+    const __m256i highVec = _mm256_set1_epi32(high);
+    const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int32_t>(stride)));
+    __m256i positions = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i step = _mm256_set1_epi32(8);
+    const bool contiguous = stride == sizeof(int32_t);
+
+    size_t selected = 0, i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const std::byte *base = values + i * stride;
+        __m256i value = contiguous ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(base))
+                                   : _mm256_i32gather_epi32(reinterpret_cast<const int *>(base), offsets, 1);
+
+        // a value passes unless it is below low or above high
+        __m256i fails = _mm256_or_si256(_mm256_cmpgt_epi32(lowVec, value), _mm256_cmpgt_epi32(value, highVec));
+        int mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(fails)) & 0xFF;
+
+        // the passing positions are packed to the front and stored together, the tail is overwritten later
+        __m256i permutation = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(compactTable[mask].data()));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(selection + selected), _mm256_permutevar8x32_epi32(positions, permutation));
+        selected += __builtin_popcount(mask);
+        positions = _mm256_add_epi32(positions, step);
+    }
+    return scalarRange(values, i, count, stride, low, high, selection, selected);
+}
+
+__attribute__((target("sse2")))
+static auto sse2Range(const std::byte *values, size_t count, size_t stride, int32_t low, int32_t high, uint32_t *selection) -> size_t
+{
+    const __m128i lowVec = _mm_set1_epi32(low);
+    const __m128i highVec = _mm_set1_epi32(high);
+    const bool contiguous = stride == sizeof(int32_t);
+
+    size_t selected = 0, i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i value = contiguous ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i * stride))
+                                   : _mm_setr_epi32(valueAt(values, stride, i), valueAt(values, stride, i + 1), valueAt(values, stride, i + 2), valueAt(values, stride, i + 3));
+        __m128i fails = _mm_or_si128(_mm_cmpgt_epi32(lowVec, value), _mm_cmpgt_epi32(value, highVec));
+        int mask = ~_mm_movemask_ps(_mm_castsi128_ps(fails)) & 0xF;
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            selection[selected] = static_cast<uint32_t>(i + lane);
+            selected += (mask >> lane) & 1;
+        }
+    }
+    return scalarRange(values, i, count, stride, low, high, selection, selected);
+}
+
+#endif
+
+// Widest kernel the CPU supports, picked on first use
+static auto rangeKernel() -> std::pair<RangeKernel, const char *>
+{
+    static const auto kernel = []() -> std::pair<RangeKernel, const char *> {
+#if defined(PREDICATE_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return {avx2Range, "avx2"};
+        }
+        if (__builtin_cpu_supports("sse2"))
+        {
+            return {sse2Range, "sse2"};
+        }
+#endif
+        return {selectRangeScalar, "scalar"};
+    }();
+    return kernel;
+}
+
+auto selectRange(const std::byte *values, size_t count, size_t stride, int32_t low, int32_t high, uint32_t *selection) -> size_t
+{
+    if (stride % sizeof(int32_t) != 0)
+    {
+        throw std::invalid_argument("Stride must be a multiple of 4 bytes");
+    }
+    if (low > high)
+    {
+        return 0;
+    }
+    return rangeKernel().first(values, count, stride, low, high, selection);
+}
+
+auto selectCompare(const std::byte *values, size_t count, size_t stride, CompareOp op, int32_t constant, uint32_t *selection) -> size_t
+{
+    // every comparison is a range of 32 bit integers, an empty one when nothing can pass
+    constexpr int32_t smallest = std::numeric_limits<int32_t>::min(), largest = std::numeric_limits<int32_t>::max();
+    switch (op)
+    {
+        case CompareOp::EQUAL:
+            return selectRange(values, count, stride, constant, constant, selection);
+        case CompareOp::LESS:
+            return constant == smallest ? 0 : selectRange(values, count, stride, smallest, constant - 1, selection);
+        case CompareOp::LESS_EQUAL:
+            return selectRange(values, count, stride, smallest, constant, selection);
+        case CompareOp::GREATER:
+            return constant == largest ? 0 : selectRange(values, count, stride, constant + 1, largest, selection);
+        case CompareOp::GREATER_EQUAL:
+            return selectRange(values, count, stride, constant, largest, selection);
+    }
+    throw std::invalid_argument("Unknown comparison");
+}
+
+auto predicateKernel() -> const char *
+{
+    return rangeKernel().second;
+}
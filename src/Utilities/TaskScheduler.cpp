@@ -0,0 +1,198 @@
+#include <Utilities/TaskScheduler.hpp>
+#include <algorithm>
+
+// Queue of the worker running on this thread, -1 outside the pool
+static thread_local size_t currentWorker = static_cast<size_t>(-1);
+
+// Scheduler owning the worker running on this thread
+static thread_local TaskScheduler *currentScheduler = nullptr;
+
+TaskScheduler::TaskScheduler(unsigned numWorkers) : numQueued(0), nextQueue(0), stopping(false)
+{
+    numWorkers = std::max(1u, numWorkers);
+    for (unsigned i = 0; i < numWorkers; ++i)
+    {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned i = 0; i < numWorkers; ++i)
+    {
+        workers.emplace_back(&TaskScheduler::workerLoop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+auto TaskScheduler::global() -> TaskScheduler &
+{
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+auto TaskScheduler::spawn(std::function<void()> task) -> void
+{
+    size_t queue = currentScheduler == this ? currentWorker : nextQueue++ % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+        queues[queue]->tasks.push_back(std::move(task));
+    }
+    {
+        // taken so a worker about to sleep cannot miss the task
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++numQueued;
+    }
+    wakeUp.notify_one();
+}
+
+auto TaskScheduler::takeTask(size_t worker) -> std::function<void()>
+{
+    if (numQueued == 0)
+    {
+        return {};
+    }
+    for (size_t i = 0; i < queues.size(); ++i)
+    {
+        WorkerQueue &queue = *queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+        {
+            continue;
+        }
+        std::function<void()> task;
+        if (i == 0)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        --numQueued;
+        return task;
+    }
+    return {};
+}
+
+auto TaskScheduler::runPending() -> bool
+{
+    // threads outside the pool start looking from a different queue each time
+    size_t worker = currentScheduler == this ? currentWorker : nextQueue++ % queues.size();
+    auto task = takeTask(worker);
+    if (!task)
+    {
+        return false;
+    }
+    task();
+    return true;
+}
+
+auto TaskScheduler::workerLoop(unsigned worker) -> void
+{
+    currentWorker = worker;
+    currentScheduler = this;
+    while (true)
+    {
+        if (auto task = takeTask(worker))
+        {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return stopping || numQueued > 0; });
+        if (stopping && numQueued == 0)
+        {
+            return;
+        }
+    }
+}
+
+TaskGroup::TaskGroup(TaskScheduler &_scheduler) : scheduler(&_scheduler), state(std::make_shared<State>())
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    try
+    {
+        wait();
+    }
+    catch (...)
+    {
+    }
+}
+
+auto TaskGroup::run(std::function<void()> task) -> void
+{
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        ++state->pending;
+    }
+    scheduler->spawn([state = state, task = std::move(task)]() {
+        if (!state->cancelled)
+        {
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->error)
+                {
+                    state->error = std::current_exception();
+                }
+                state->cancelled = true;
+            }
+        }
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (--state->pending == 0)
+        {
+            state->done.notify_all();
+        }
+    });
+}
+
+auto TaskGroup::cancel() -> void
+{
+    state->cancelled = true;
+}
+
+auto TaskGroup::wait() -> void
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            if (state->pending == 0)
+            {
+                break;
+            }
+        }
+        if (!scheduler->runPending())
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->done.wait_for(lock, std::chrono::milliseconds(1), [this]() { return state->pending == 0; });
+        }
+    }
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        std::swap(error, state->error);
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
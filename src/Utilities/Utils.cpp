@@ -1,26 +1,61 @@
 #include <Utilities/Utils.hpp>
 #include <Storage/BufferManager.hpp>
+#include <Storage/SpaceManager.hpp>
 #include <cstring>
 #include <iostream>
+#include <filesystem>
 
-auto loadFileInDisk (BufferManager& buffer, std::string fileName, address_id_t startingAddress) -> std::optional<std::pair<address_id_t, address_id_t>>
+auto bulkWrite (BufferManager& buffer, address_id_t address, std::span<const std::byte> data) -> void
+{
+	const storage_t blockSize = buffer.getBlockSize();
+
+	// a head that does not start on a page boundary is merged into its page through the pool
+	storage_t headSize = std::min<storage_t>( ( blockSize - address % blockSize ) % blockSize, data.size() );
+	if ( headSize > 0 )
+	{
+		buffer.writeAddress( address, data.first( headSize ) );
+		address += headSize;
+		data = data.subspan( headSize );
+	}
+
+	// whole pages go straight to the disk, the partial last page through the pool
+	storage_t wholePages = data.size() / blockSize * blockSize;
+	if ( wholePages > 0 )
+	{
+		buffer.writePages( address / blockSize, data.first( wholePages ) );
+	}
+	if ( data.size() > wholePages )
+	{
+		buffer.writeAddress( address + wholePages, data.subspan( wholePages ) );
+	}
+}
+
+auto loadFileInDisk (BufferManager& buffer, std::string fileName, address_id_t startingAddress, const LoadObserver &observe) -> std::optional<std::pair<address_id_t, address_id_t>>
 {
 	address_id_t endAddress = startingAddress;
 	try {
 		std::ifstream file { fileName, std::ios::binary };
-		std::array<std::byte, 128> ReadBuffer;
 		if ( ! file.is_open() )
 		{
 			std::cerr << "Error opening file" << '\n';
 			return std::nullopt;
 		}
-		while ( file.read( reinterpret_cast<char*> ( ReadBuffer.data() ), ReadBuffer.size() ) )
+		const storage_t blockSize = buffer.getBlockSize();
+		std::vector<std::byte> chunk( LOAD_CHUNK_PAGES * blockSize );
+
+		// the first chunk ends on a page boundary, so every later chunk is made of whole pages
+		storage_t chunkSize = chunk.size() - startingAddress % blockSize;
+		while ( file && file.read( reinterpret_cast<char*> ( chunk.data() ), chunkSize ).gcount() > 0 )
 		{
-			buffer.writeAddress( endAddress, std::vector<std::byte>( ReadBuffer.begin(), ReadBuffer.end() ) );
-			endAddress += ReadBuffer.size();
+			std::span<const std::byte> data( chunk.data(), file.gcount() );
+			bulkWrite( buffer, endAddress, data );
+			if ( observe )
+			{
+				observe( endAddress, data );
+			}
+			endAddress += file.gcount();
+			chunkSize = chunk.size();
 		}
-		file.close();
-		file.clear();
 	}
 	catch (const std::exception &e ) {
 		std::cerr << e.what() << std::endl;
@@ -34,63 +69,34 @@ auto getNextFreeFrame(int readBytes, block_id_t blockSize) -> int
     return usedFrameCnt * BLOCK_SIZE;
 }
 
-template <typename T>
-auto extractData(const std::vector<std::byte> &data) -> T
+auto loadData(block_id_t blockSize, storage_t diskSize, storage_t bufferSize, const LoadObserver &observeEmployees, const LoadObserver &observeCompanies) -> std::tuple<address_id_t, address_id_t, address_id_t, address_id_t>
 {
-    T result;
-    std::memcpy(&result, data.data(), sizeof(T));
-    return result;
+    Disk disk(RANDOM, blockSize, diskSize);
+    BufferManager buffer(&disk, MRU, bufferSize);
+    return loadData(buffer, observeEmployees, observeCompanies);
 }
 
-template Employee extractData<Employee>(const std::vector<std::byte> &data);
-template Company extractData<Company>(const std::vector<std::byte> &data);
-template JoinEmployeeCompany extractData<JoinEmployeeCompany>(const std::vector<std::byte> &data);
-
-auto loadData(block_id_t blockSize, storage_t diskSize, storage_t bufferSize) -> std::tuple<address_id_t, address_id_t, address_id_t, address_id_t>
+auto loadData(BufferManager &buffer, const LoadObserver &observeEmployees, const LoadObserver &observeCompanies) -> std::tuple<address_id_t, address_id_t, address_id_t, address_id_t>
 {
-    Disk disk(RANDOM, blockSize, diskSize);
-    BufferManager buffer(&disk, MRU, bufferSize);
+    // a fresh load owns the whole disk, anything allocated by an earlier run is dropped
+    SpaceManager space(&buffer);
+    space.format();
 
-    auto locationEmployee = loadFileInDisk(buffer, BIN_DIR + "employee.bin", 0);
-    if (!locationEmployee.has_value())
+    auto loadTable = [&](std::string fileName, const LoadObserver &observe) -> std::pair<address_id_t, address_id_t>
     {
-        std::cerr << "Error loading Employee data" << std::endl;
-        exit(1);
-    }
-    auto [StartAddressEmployee, EndAddressEmployee] = locationEmployee.value();
+        std::error_code ec;
+        auto fileSize = std::filesystem::file_size(fileName, ec);
+        auto extent = ec ? std::nullopt : space.allocate(fileSize);
+        auto location = extent.has_value() ? loadFileInDisk(buffer, fileName, extent->start, observe) : std::nullopt;
+        if (!location.has_value())
+        {
+            std::cerr << "Error loading " << fileName << std::endl;
+            exit(1);
+        }
+        return location.value();
+    };
 
-    auto locationCompany = loadFileInDisk(buffer, BIN_DIR + "company.bin", EndAddressEmployee);
-    if (!locationCompany.has_value())
-    {
-        std::cerr << "Error loading Company data" << std::endl;
-        exit(1);
-    }
-    auto [StartAddressCompany, EndAddressCompany] = locationCompany.value();
+    auto [StartAddressEmployee, EndAddressEmployee] = loadTable(BIN_DIR + "employee.bin", observeEmployees);
+    auto [StartAddressCompany, EndAddressCompany] = loadTable(BIN_DIR + "company.bin", observeCompanies);
     return {StartAddressEmployee, EndAddressEmployee, StartAddressCompany, EndAddressCompany};
 }
-
-template <typename T>
-auto storeResult(BufferManager &buffer, address_id_t start, address_id_t end, std::string fileName) -> void
-{
-    T storeData;
-    auto size = T::size;
-    std::ofstream file(fileName);
-    if (!file.is_open())
-    {
-        std::cerr << "Error opening file" << '\n';
-        return;
-    }
-    file << T::getTitle() << std::endl;
-    for (address_id_t i = start; i < end; i += size)
-    {
-        auto data = buffer.readAddress(i, size);
-        storeData = extractData<T>(data);
-        file << storeData.toString() << std::endl;
-    }
-    file.close();
-    return;
-}
-
-template void storeResult<Employee>(BufferManager &buffer, address_id_t start, address_id_t end, std::string fileName);
-template void storeResult<Company>(BufferManager &buffer, address_id_t start, address_id_t end, std::string fileName);
-template void storeResult<JoinEmployeeCompany>(BufferManager &buffer, address_id_t start, address_id_t end, std::string fileName);
\ No newline at end of file
@@ -1,134 +1,45 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <queue>
+#include <cstring>
 #include <cassert>
 #include <Storage/Disk.hpp>
 #include <Storage/BufferManager.hpp>
+#include <Storage/SpaceManager.hpp>
+#include <Storage/RecordView.hpp>
 #include <Utilities/Utils.hpp>
+#include <Utilities/Schema.hpp>
+#include <Utilities/ColumnarFile.hpp>
+#include <Execution/ExternalSorter.hpp>
 
 std::ofstream outFile(STAT_DIR + "external_sort_stats.txt", std::ios::out | std::ios::trunc);
 
-template <typename T>
-auto mergeRuns(BufferManager &buffer, const std::vector<std::pair<address_id_t, address_id_t>> &Runs, address_id_t NextUsableAddress) -> std::pair<address_id_t, address_id_t>
+// Joins two inputs sorted on their schema keys, every left record joins at most one right record
+template <typename L, typename R, typename Out>
+auto mergeJoin(BufferManager &buffer, address_id_t startLeft, address_id_t endLeft, address_id_t startRight, address_id_t endRight, address_id_t NextUsableAddress) -> std::pair<address_id_t, address_id_t>
 {
-    const bool isEmployee = std::is_same_v<T, Employee>;
-    const auto size = (isEmployee) ? EmployeeSize : CompanySize;
+    // Both inputs are read in place from pinned frames
     address_id_t baseAddress = NextUsableAddress;
-    size_t runCount = Runs.size();
-    std::priority_queue<std::tuple<T, size_t, address_id_t>, std::vector<std::tuple<T, size_t, address_id_t>>, std::greater<std::tuple<T, size_t, address_id_t>>> minHeap;
-    for (size_t i = 0; i < runCount; ++i)
+    RecordCursor<L> left(buffer, startLeft, endLeft);
+    RecordCursor<R> right(buffer, startRight, endRight);
+    while (left.valid() && right.valid())
     {
-        minHeap.push({extractData<T>(buffer.readAddress(Runs[i].first, size)), i, Runs[i].first});
-    }
-    while (!minHeap.empty())
-    {
-        auto [data, runIndex, address] = minHeap.top();
-        minHeap.pop();
-        buffer.writeAddress(baseAddress, std::vector<std::byte>(reinterpret_cast<std::byte *>(&data), reinterpret_cast<std::byte *>(&data) + size));
-        baseAddress += size;
-        if (address + size < Runs[runIndex].second)
+        const L &leftData = left.get();
+        const R &rightData = right.get();
+        if (keyOf(leftData) == keyOf(rightData))
         {
-            auto nextData = extractData<T>(buffer.readAddress(address + size, size));
-            minHeap.push({nextData, runIndex, address + size});
+            Out joinData(leftData, rightData);
+            buffer.writeAddress(baseAddress, recordBytes(joinData));
+            baseAddress += sizeof(Out);
+            left.advance();
         }
-    }
-    return std::make_pair(NextUsableAddress, baseAddress);
-}
-
-template <typename T>
-auto externalSort(BufferManager &buffer, address_id_t StartAddress, address_id_t EndAddress, address_id_t NextUsableAddress) -> std::pair<int, int> // Returns the Start and the End index of the final Sorted data
-{
-    const bool isEmployee = std::is_same_v<T, Employee>;
-    const auto size = (isEmployee) ? EmployeeSize : CompanySize;
-    const address_id_t dataSize = EndAddress - StartAddress;
-    // Sorting the Data and storing it in the same Blocks in Disk
-    std::vector<T> dataInBlock;
-    std::vector<std::pair<address_id_t, address_id_t>> Runs;
-    for (address_id_t i = StartAddress; i < EndAddress; i += BUFFER_SIZE)
-    {
-        Runs.push_back({i, std::min(EndAddress, i + BUFFER_SIZE)});
-        auto data = buffer.readAddress(i, std::min(EndAddress, i + BUFFER_SIZE));
-        dataInBlock.insert(dataInBlock.end(), reinterpret_cast<T *>(data.data()), reinterpret_cast<T *>(data.data() + std::min((storage_t) BUFFER_SIZE, EndAddress - i)));
-        std::ranges::sort(dataInBlock.begin(), dataInBlock.end()); // Merge Sort each Block
-        buffer.writeAddress(i, std::vector<std::byte>(reinterpret_cast<std::byte *>(dataInBlock.data()), reinterpret_cast<std::byte *>(dataInBlock.data() + dataInBlock.size())));
-        dataInBlock.clear();
-    }
-
-    // Merging the Sorted Blocks
-    size_t usedFrameCnt = (EndAddress - StartAddress + BLOCK_SIZE - 1) / BLOCK_SIZE;
-    std::pair<address_id_t, address_id_t> result;
-    if (usedFrameCnt < buffer.getNumFrames() - 1)
-    {
-        //  Merged in a single Run
-        result = mergeRuns<T>(buffer, Runs, NextUsableAddress);
-    }
-    else
-    {
-        std::vector<std::pair<address_id_t, address_id_t>> nextRuns;
-        bool toUse = false; // if false use NextUsableAddress or use StartAddress replacably
-        while (Runs.size() > buffer.getNumFrames() - 1)
+        else if (keyOf(leftData) < keyOf(rightData))
         {
-            address_id_t toFillIndex = (toUse) ? StartAddress : NextUsableAddress;
-            for (size_t i = 0; i < Runs.size(); i += (buffer.getNumFrames() - 1))
-            {
-                std::vector<std::pair<address_id_t, address_id_t>> tempRuns;
-                for (size_t j = i; j < i + (buffer.getNumFrames() - 1) && j < Runs.size(); ++j)
-                {
-                    tempRuns.push_back(Runs[j]);
-                }
-                auto mergedRun = mergeRuns<T>(buffer, tempRuns, toFillIndex);
-                nextRuns.push_back(mergedRun);
-                toFillIndex = mergedRun.second;
-            }
-            Runs = nextRuns;
-            nextRuns.clear();
-            toUse = !toUse;
-        }
-        address_id_t toFillIndex = (toUse) ? StartAddress : NextUsableAddress;
-        result = mergeRuns<T>(buffer, Runs, toFillIndex);
-    }
-    if (result.first == NextUsableAddress)
-    {
-        address_id_t readAddr = NextUsableAddress;
-        address_id_t writeAddr = StartAddress;
-        for (address_id_t i = readAddr; i < result.second; i += size)
-        {
-            auto data = buffer.readAddress(i, size);
-            buffer.writeAddress(writeAddr, data);
-            readAddr += size;
-            writeAddr += size;
-        }
-        result.first = StartAddress;
-        result.second = StartAddress + dataSize;
-    }
-    return result;
-}
-
-auto mergeJoin(BufferManager &buffer, address_id_t startEmployee, address_id_t endEmployee, address_id_t startCompany, address_id_t endCompany, address_id_t NextUsableAddress) -> std::pair<address_id_t, address_id_t>
-{
-    // Pinning and Not based implementation
-    address_id_t baseAddress = NextUsableAddress;
-    address_id_t employeePtr = startEmployee;
-    address_id_t companyPtr = startCompany;
-    while (employeePtr < endEmployee && companyPtr < endCompany)
-    {
-        auto employeeData = extractData<Employee>(buffer.readAddress(employeePtr, EmployeeSize));
-        auto companyData = extractData<Company>(buffer.readAddress(companyPtr, CompanySize));
-        if (employeeData.company_id == companyData.id)
-        {
-            JoinEmployeeCompany joinData(employeeData, companyData);
-            buffer.writeAddress(baseAddress, std::vector<std::byte>(reinterpret_cast<std::byte *>(&joinData), reinterpret_cast<std::byte *>(&joinData) + JoinedSize));
-            baseAddress += JoinedSize;
-            employeePtr += EmployeeSize;
-        }
-        else if (employeeData.company_id < companyData.id)
-        {
-            employeePtr += EmployeeSize;
+            left.advance();
         }
         else
         {
-            companyPtr += CompanySize;
+            right.advance();
         }
     }
     return std::make_pair(NextUsableAddress, baseAddress);
@@ -136,34 +47,47 @@ auto mergeJoin(BufferManager &buffer, address_id_t startEmployee, address_id_t e
 
 auto testing(bool DiskAccessStrategy, int BufferReplacementStategy) -> void
 {
-    auto [StartAddressEmployee, EndAddressEmployee, StartAddressCompany, EndAddressCompany] = loadData();
     Disk disk(DiskAccessStrategy, BLOCK_SIZE, DISK_SIZE);
     BufferManager buffer(&disk, BufferReplacementStategy, BUFFER_SIZE);
+    auto [StartAddressEmployee, EndAddressEmployee, StartAddressCompany, EndAddressCompany] = loadData(buffer);
+    SpaceManager space(&buffer);
 
     auto stat = buffer.getStats();
 
-    // External Sort the Employee and Company data
-    address_id_t NextUsableAddress = getNextFreeFrame(EndAddressCompany);
-    auto [startEmployeeSorted, endEmployeeSorted] = externalSort<Employee>(buffer, StartAddressEmployee, EndAddressEmployee, NextUsableAddress);
-    auto [startCompanySorted, endCompanySorted] = externalSort<Company>(buffer, StartAddressCompany, EndAddressCompany, NextUsableAddress);
+    // External Sort the Employee and Company data on their schema keys
+    auto employeesSorted = ExternalSorter<Employee>(buffer, space, SortKey<Employee>::schemaKey(), DRIVER_THREADS).sort(StartAddressEmployee, EndAddressEmployee);
+    auto companiesSorted = ExternalSorter<Company>(buffer, space, SortKey<Company>::schemaKey(), DRIVER_THREADS).sort(StartAddressCompany, EndAddressCompany);
+    const address_id_t startEmployeeSorted = employeesSorted.extent.start, endEmployeeSorted = employeesSorted.end;
+    const address_id_t startCompanySorted = companiesSorted.extent.start, endCompanySorted = companiesSorted.end;
 
     buffer.printStats(outFile, stat, "Statistics of the External Sort");
     stat = buffer.getStats();
     
-    // Merge Join the Employee and Company data
-    auto [startJoin, endJoin] = mergeJoin(buffer, startEmployeeSorted, endEmployeeSorted, startCompanySorted, endCompanySorted, NextUsableAddress);
+    // Merge Join the Employee and Company data, every employee joins at most one company
+    auto joinExtent = space.allocate((endEmployeeSorted - startEmployeeSorted) / EmployeeSize * JoinedSize);
+    if (!joinExtent.has_value())
+    {
+        std::cerr << "Not enough free space for the join result" << std::endl;
+        space.release(companiesSorted.extent);
+        space.release(employeesSorted.extent);
+        return;
+    }
+    auto [startJoin, endJoin] = mergeJoin<Employee, Company, JoinEmployeeCompany>(buffer, startEmployeeSorted, endEmployeeSorted, startCompanySorted, endCompanySorted, joinExtent->start);
 
     // print statistics
     buffer.printStats(outFile, stat, "Statistics of the Merge Join (excluding sorting)"); 
     std::string s = (BufferReplacementStategy == LRU ? "_lru" : "_mru");
     s += (DiskAccessStrategy == RANDOM ? "_rand" : "_seq");
-    s += ".csv";
 
     // Storing the sorted files for Demonstration
-    storeResult<Employee>(buffer, startEmployeeSorted, endEmployeeSorted, RES_DIR + "merge_join_sorted_employee" + s);
-    storeResult<Company>(buffer, startCompanySorted, endCompanySorted, RES_DIR + "merge_join_sorted_company" + s);
-    storeResult<JoinEmployeeCompany>(buffer, startJoin, endJoin, RES_DIR + "merge_join_joined_result" + s);
+    storeResult<Employee>(buffer, startEmployeeSorted, endEmployeeSorted, RES_DIR + "merge_join_sorted_employee" + s + ".csv");
+    storeResult<Company>(buffer, startCompanySorted, endCompanySorted, RES_DIR + "merge_join_sorted_company" + s + ".csv");
+    storeResult<JoinEmployeeCompany>(buffer, startJoin, endJoin, RES_DIR + "merge_join_joined_result" + s + ".csv", DRIVER_THREADS);
+    storeColumnar<JoinEmployeeCompany>(buffer, startJoin, endJoin, RES_DIR + "merge_join_joined_result" + s + ".col");
 
+    space.release(joinExtent.value());
+    space.release(companiesSorted.extent);
+    space.release(employeesSorted.extent);
     return;
 }
 
@@ -1,7 +1,12 @@
 #include <Utilities/Utils.hpp>
+#include <Utilities/Schema.hpp>
+#include <Utilities/ColumnarFile.hpp>
 #include <Storage/BufferManager.hpp>
 #include <Storage/Disk.hpp>
+#include <Storage/SpaceManager.hpp>
+#include <Storage/RecordView.hpp>
 #include <Indexes/HashIndex.hpp>
+#include <Execution/GraceHashJoin.hpp>
 
 #include <iostream>
 #include <vector>
@@ -20,27 +25,41 @@ std::ofstream outFile(STAT_DIR + "hash_index_stats.txt", std::ios::out | std::io
 int help(storage_t blockSize, storage_t diskSize, storage_t bufferSize, int replaceStrategy, int accessType){
     Disk disk(accessType, blockSize, diskSize);
     BufferManager bm(&disk, replaceStrategy, bufferSize);
+    SpaceManager space(&bm);
 
     auto stat = bm.getStats();
 
-    ExtendableHashIndex<int, address_id_t> comp_index(&bm, 2, 0, companyEndAddress);
-    for( int i = 0; i < COMP_SIZE; ++i )
+    // The index size is unknown up front, take the largest free extent and trim it once built
+    auto indexExtent = space.allocateLargest();
+    if (!indexExtent.has_value())
     {
-        address_id_t addr = companyStartAddress + i * sizeof(Company);
-        Company comp = extractData<Company>(bm.readAddress(addr, sizeof(Company)));
-        comp_index.insert( comp.id, addr );
-        // std::cout << "Inserted company ID: " << comp.id << " with record at address: " << addr << std::endl;
+        std::cerr << "Not enough free space for the hash index" << std::endl;
+        return 1;
+    }
+    ExtendableHashIndex<int, address_id_t> comp_index(&bm, 2, 0, indexExtent->start);
+    for( RecordCursor<Company> cursor(bm, companyStartAddress, companyEndAddress); cursor.valid(); cursor.advance() )
+    {
+        comp_index.insert( cursor.get().id, cursor.address() );
+        // std::cout << "Inserted company ID: " << cursor.get().id << " with record at address: " << cursor.address() << std::endl;
     }
     // std::cout<<comp_index<<std::endl;
     auto [compStartIndex, compEndIndex] = comp_index.getAddressRange();
+    space.shrink(indexExtent.value(), compEndIndex - compStartIndex);
 
     bm.printStats(outFile, stat, "Statistics for the creation of Hash Index");
     stat = bm.getStats();
 
-    address_id_t joinAddress = compEndIndex;
-    for(address_id_t addr = employeeStartAddress; addr < employeeEndAddress; addr += sizeof(Employee))
+    // Every employee joins at most one company
+    auto joinExtent = space.allocate((employeeEndAddress - employeeStartAddress) / sizeof(Employee) * sizeof(JoinEmployeeCompany));
+    if (!joinExtent.has_value())
     {
-        Employee emp = extractData<Employee>(bm.readAddress(addr, sizeof(Employee)));
+        std::cerr << "Not enough free space for the join result" << std::endl;
+        return 1;
+    }
+    address_id_t joinAddress = joinExtent->start;
+    for(RecordCursor<Employee> cursor(bm, employeeStartAddress, employeeEndAddress); cursor.valid(); cursor.advance())
+    {
+        const Employee &emp = cursor.get();
         auto compAddr = comp_index.search(emp.company_id);
         if(!compAddr.has_value())
         {
@@ -48,17 +67,37 @@ int help(storage_t blockSize, storage_t diskSize, storage_t bufferSize, int repl
             continue;
         }
         // std::cout << "Joining Employee ID: " << emp.id << " with Company ID: " << emp.company_id << std::endl;
-        Company comp = extractData<Company>(bm.readAddress(compAddr.value(), sizeof(Company)));
-        JoinEmployeeCompany joinData(emp, comp);
-        bm.writeAddress(joinAddress, std::vector<std::byte>(reinterpret_cast<std::byte *>(&joinData), reinterpret_cast<std::byte *>(&joinData) + sizeof(JoinEmployeeCompany)));
+        auto comp = viewRecord<Company>(bm, compAddr.value());
+        JoinEmployeeCompany joinData(emp, comp.get());
+        bm.writeAddress(joinAddress, recordBytes(joinData));
         joinAddress += sizeof(JoinEmployeeCompany);
     }
 
     bm.printStats(outFile, stat, "Statistics for the join operation(using Hash Index)");
     stat = bm.getStats();
 
-    storeResult<JoinEmployeeCompany>(bm, compEndIndex, joinAddress, RES_DIR + "hash_index_join_data_" + (replaceStrategy == LRU ? "lru" : "mru") + "_" + (accessType == RANDOM ? "rand" : "seq") + ".csv");
+    storeResult<JoinEmployeeCompany>(bm, joinExtent->start, joinAddress, RES_DIR + "hash_index_join_data_" + (replaceStrategy == LRU ? "lru" : "mru") + "_" + (accessType == RANDOM ? "rand" : "seq") + ".csv", DRIVER_THREADS);
+    storeColumnar<JoinEmployeeCompany>(bm, joinExtent->start, joinAddress, RES_DIR + "hash_index_join_data_" + (replaceStrategy == LRU ? "lru" : "mru") + "_" + (accessType == RANDOM ? "rand" : "seq") + ".col");
+
+    space.release(joinExtent.value());
+    space.release(indexExtent.value());
+
+    // Grace hash join: both relations are partitioned to disk by company id, then joined partition by partition
+    stat = bm.getStats();
+    joinExtent = space.allocate((employeeEndAddress - employeeStartAddress) / sizeof(Employee) * sizeof(JoinEmployeeCompany));
+    if (!joinExtent.has_value())
+    {
+        std::cerr << "Not enough free space for the join result" << std::endl;
+        return 1;
+    }
+    GraceHashJoin<Employee, Company, JoinEmployeeCompany> graceJoin(bm, space);
+    joinAddress = graceJoin.join(employeeStartAddress, employeeEndAddress, companyStartAddress, companyEndAddress, joinExtent->start);
+
+    bm.printStats(outFile, stat, "Statistics for the join operation(using Grace Hash Join)");
+
+    storeResult<JoinEmployeeCompany>(bm, joinExtent->start, joinAddress, RES_DIR + "grace_hash_join_data_" + (replaceStrategy == LRU ? "lru" : "mru") + "_" + (accessType == RANDOM ? "rand" : "seq") + ".csv", DRIVER_THREADS);
 
+    space.release(joinExtent.value());
     return 0;
 
 }
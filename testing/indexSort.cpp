@@ -1,6 +1,10 @@
 #include <Utilities/Utils.hpp>
+#include <Utilities/Schema.hpp>
+#include <Utilities/ColumnarFile.hpp>
 #include <Storage/BufferManager.hpp>
 #include <Storage/Disk.hpp>
+#include <Storage/SpaceManager.hpp>
+#include <Storage/RecordView.hpp>
 #include <Indexes/BPlusTreeIndex.hpp>
 
 #include <iostream>
@@ -18,26 +22,39 @@ int help(storage_t blockSize, storage_t diskSize, storage_t bufferSize, int repl
 {
     Disk disk(accessType, blockSize, diskSize);
     BufferManager bm(&disk, replaceStrategy, bufferSize);
+    SpaceManager space(&bm);
 
     auto stat = bm.getStats();
 
-    BPlusTreeIndex< unsigned long long, address_id_t > emp_index(&bm, 10, companyEndAddress);
-    for ( int i = 0; i < EMP_SIZE; ++i )
+    // Index sizes are unknown up front, each takes the largest free extent and trims it once built
+    auto empExtent = space.allocateLargest();
+    if (!empExtent.has_value())
     {
-        address_id_t addr = employeeStartAddress + i * sizeof(Employee);
-        Employee emp = extractData<Employee>(bm.readAddress(addr, sizeof(Employee)));
-        emp_index.insert( emp.company_id * 1e5 + emp.id, addr );
+        std::cerr << "Not enough free space for the employee index" << std::endl;
+        return 1;
+    }
+    BPlusTreeIndex< unsigned long long, address_id_t > emp_index(&bm, 10, empExtent->start);
+    for ( RecordCursor<Employee> cursor(bm, employeeStartAddress, employeeEndAddress); cursor.valid(); cursor.advance() )
+    {
+        const Employee &emp = cursor.get();
+        emp_index.insert( emp.company_id * 1e5 + emp.id, cursor.address() );
     }
     auto [empStartIndex, empEndIndex] = emp_index.getAddressRange();
+    space.shrink(empExtent.value(), empEndIndex - empStartIndex);
 
-    BPlusTreeIndex< unsigned long long, address_id_t > comp_index(&bm, 10, empEndIndex);
-    for( int i = 0; i < COMP_SIZE; ++i )
+    auto compExtent = space.allocateLargest();
+    if (!compExtent.has_value())
     {
-        address_id_t addr = companyStartAddress + i * sizeof(Company);
-        Company comp = extractData<Company>(bm.readAddress(addr, sizeof(Company)));
-        comp_index.insert( comp.id, addr );
+        std::cerr << "Not enough free space for the company index" << std::endl;
+        return 1;
+    }
+    BPlusTreeIndex< unsigned long long, address_id_t > comp_index(&bm, 10, compExtent->start);
+    for( RecordCursor<Company> cursor(bm, companyStartAddress, companyEndAddress); cursor.valid(); cursor.advance() )
+    {
+        comp_index.insert( cursor.get().id, cursor.address() );
     }
     auto [compStartIndex, compEndIndex] = comp_index.getAddressRange();
+    space.shrink(compExtent.value(), compEndIndex - compStartIndex);
 
     bm.printStats(outFile, stat, "Statistics for the creation of B+ Tree Index");
     stat = bm.getStats();
@@ -45,7 +62,14 @@ int help(storage_t blockSize, storage_t diskSize, storage_t bufferSize, int repl
     auto empBegin = emp_index.begin();
     auto compBegin = comp_index.begin();
 
-    address_id_t joinAddr = compEndIndex;
+    // Every employee joins at most one company
+    auto joinExtent = space.allocate((employeeEndAddress - employeeStartAddress) / sizeof(Employee) * sizeof(JoinEmployeeCompany));
+    if (!joinExtent.has_value())
+    {
+        std::cerr << "Not enough free space for the join result" << std::endl;
+        return 1;
+    }
+    address_id_t joinAddr = joinExtent->start;
     while( empBegin != emp_index.end() && compBegin != comp_index.end() )
     {
         auto [empKey, empValue] = *empBegin;
@@ -53,10 +77,10 @@ int help(storage_t blockSize, storage_t diskSize, storage_t bufferSize, int repl
 
         if( empKey / (int) 1e5 == compKey )
         {
-            Employee emp = extractData<Employee>(bm.readAddress(empValue, sizeof(Employee)));
-            Company comp = extractData<Company>(bm.readAddress(compValue, sizeof(Company)));
-            JoinEmployeeCompany joinData(emp, comp);
-            bm.writeAddress(joinAddr, std::vector<std::byte>(reinterpret_cast<std::byte*>(&joinData), reinterpret_cast<std::byte*>(&joinData) + sizeof(JoinEmployeeCompany)));
+            auto emp = viewRecord<Employee>(bm, empValue);
+            auto comp = viewRecord<Company>(bm, compValue);
+            JoinEmployeeCompany joinData(emp.get(), comp.get());
+            bm.writeAddress(joinAddr, recordBytes(joinData));
             joinAddr += sizeof(JoinEmployeeCompany);
             ++empBegin;
         }
@@ -67,8 +91,12 @@ int help(storage_t blockSize, storage_t diskSize, storage_t bufferSize, int repl
     bm.printStats(outFile, stat, "Statistics for the Join using Index operation");
 
     // Store the result in a file
-    storeResult<JoinEmployeeCompany>(bm, compEndIndex, joinAddr, RES_DIR + "bplus_index_joined_data_" + (replaceStrategy == LRU ? "lru" : "mru") + "_" + (accessType == RANDOM ? "rand" : "seq") + ".csv");
+    storeResult<JoinEmployeeCompany>(bm, joinExtent->start, joinAddr, RES_DIR + "bplus_index_joined_data_" + (replaceStrategy == LRU ? "lru" : "mru") + "_" + (accessType == RANDOM ? "rand" : "seq") + ".csv", DRIVER_THREADS);
+    storeColumnar<JoinEmployeeCompany>(bm, joinExtent->start, joinAddr, RES_DIR + "bplus_index_joined_data_" + (replaceStrategy == LRU ? "lru" : "mru") + "_" + (accessType == RANDOM ? "rand" : "seq") + ".col");
 
+    space.release(joinExtent.value());
+    space.release(compExtent.value());
+    space.release(empExtent.value());
     return 0;
 }
 
@@ -5,7 +5,13 @@
 #include <cstring>
 #include <Storage/Disk.hpp>
 #include <Storage/BufferManager.hpp>
+#include <Storage/SpaceManager.hpp>
+#include <Storage/RecordView.hpp>
 #include <Utilities/Utils.hpp>
+#include <Utilities/Schema.hpp>
+#include <Utilities/ColumnarFile.hpp>
+#include <Utilities/DictionaryEncoding.hpp>
+#include <Utilities/ZoneMap.hpp>
 
 #define EMPLOYEE 0
 #define COMPANY 1
@@ -15,52 +21,52 @@ address_id_t EndAddressEmployee = 0;
 address_id_t StartAddressCompany = 0;
 address_id_t EndAddressCompany = 0;
 
+// join key summaries of both relations, built while loading
+ZoneMap<Employee> employeeZones(BLOCK_SIZE, {fieldIndex<&Employee::company_id>()});
+ZoneMap<Company> companyZones(BLOCK_SIZE, {fieldIndex<&Company::id>()});
+
 std::ofstream outFile(STAT_DIR + "nested_join_stats.txt", std::ios::out | std::ios::trunc);
 
 auto join(BufferManager &buffer, address_id_t StartAddressEmployee, address_id_t EndAddressEmployee, address_id_t StartAddressCompany, address_id_t EndAddressCompany, address_id_t NextUsableAddress, bool Outer) -> std::pair<address_id_t, address_id_t>
 {
     address_id_t baseAddress = NextUsableAddress;
 
+    // Records are read in place from pinned frames, the outer page stays pinned during the inner scan
     if (Outer)
     {
-        address_id_t employeePtr = StartAddressEmployee;
-        while ( employeePtr < EndAddressEmployee )
+        for (RecordCursor<Employee> employee(buffer, StartAddressEmployee, EndAddressEmployee); employee.valid(); employee.advance())
         {
-            auto employeeData = extractData<Employee>(buffer.readAddress(employeePtr, EmployeeSize));
-            address_id_t companyPtr = StartAddressCompany;
-            while ( companyPtr < EndAddressCompany )
-            {
-                auto companyData = extractData<Company>(buffer.readAddress(companyPtr, CompanySize));
-                if ( employeeData.company_id == companyData.id )
+            const Employee &employeeData = employee.get();
+            // inner pages that cannot hold the key are skipped
+            companyZones.scan(buffer, StartAddressCompany, EndAddressCompany, fieldIndex<&Company::id>(), keyOf(employeeData), keyOf(employeeData), [&](std::span<const Company> companies, address_id_t) {
+                for (const Company &companyData : companies)
                 {
-                    JoinEmployeeCompany joinData(employeeData, companyData);
-                    buffer.writeAddress(baseAddress, std::vector<std::byte>(reinterpret_cast<std::byte *>(&joinData), reinterpret_cast<std::byte *>(&joinData) + JoinEmployeeCompany::size));
-                    baseAddress += JoinEmployeeCompany::size;
+                    if ( keyOf(employeeData) == keyOf(companyData) )
+                    {
+                        JoinEmployeeCompany joinData(employeeData, companyData);
+                        buffer.writeAddress(baseAddress, recordBytes(joinData));
+                        baseAddress += JoinEmployeeCompany::size;
+                    }
                 }
-                companyPtr += CompanySize;
-            }
-            employeePtr += EmployeeSize;
+            });
         }
     }
     else 
     {
-        address_id_t companyPtr = StartAddressCompany;
-        while ( companyPtr < EndAddressCompany )
+        for (RecordCursor<Company> company(buffer, StartAddressCompany, EndAddressCompany); company.valid(); company.advance())
         {
-            auto companyData = extractData<Company>(buffer.readAddress(companyPtr, CompanySize));
-            address_id_t employeePtr = StartAddressEmployee;
-            while ( employeePtr < EndAddressEmployee )
-            {
-                auto employeeData = extractData<Employee>(buffer.readAddress(employeePtr, EmployeeSize));
-                if ( employeeData.company_id == companyData.id )
+            const Company &companyData = company.get();
+            employeeZones.scan(buffer, StartAddressEmployee, EndAddressEmployee, fieldIndex<&Employee::company_id>(), keyOf(companyData), keyOf(companyData), [&](std::span<const Employee> employees, address_id_t) {
+                for (const Employee &employeeData : employees)
                 {
-                    JoinEmployeeCompany joinData(employeeData, companyData);
-                    buffer.writeAddress(baseAddress, std::vector<std::byte>(reinterpret_cast<std::byte *>(&joinData), reinterpret_cast<std::byte *>(&joinData) + JoinEmployeeCompany::size));
-                    baseAddress += JoinEmployeeCompany::size;
+                    if ( keyOf(employeeData) == keyOf(companyData) )
+                    {
+                        JoinEmployeeCompany joinData(employeeData, companyData);
+                        buffer.writeAddress(baseAddress, recordBytes(joinData));
+                        baseAddress += JoinEmployeeCompany::size;
+                    }
                 }
-                employeePtr += EmployeeSize;
-            }
-            companyPtr += CompanySize;
+            });
         }
     }
 
@@ -71,11 +77,19 @@ auto testing(bool DiskAccessStrategy, int BufferReplacementStategy, bool Outer)
 {
     Disk disk(DiskAccessStrategy, BLOCK_SIZE, DISK_SIZE);
     BufferManager buffer(&disk, BufferReplacementStategy, BUFFER_SIZE);
+    SpaceManager space(&buffer);
 
     auto stat = buffer.getStats();
 
-    address_id_t NextUsableAddress = getNextFreeFrame(EndAddressCompany);
-    auto [StartJoin, EndJoin] = join(buffer, StartAddressEmployee, EndAddressEmployee, StartAddressCompany, EndAddressCompany, NextUsableAddress, Outer);
+    // The result size is unknown up front, take the largest free extent and trim it afterwards
+    auto joinExtent = space.allocateLargest();
+    if (!joinExtent.has_value())
+    {
+        std::cerr << "Not enough free space for the join result" << std::endl;
+        return;
+    }
+    auto [StartJoin, EndJoin] = join(buffer, StartAddressEmployee, EndAddressEmployee, StartAddressCompany, EndAddressCompany, joinExtent->start, Outer);
+    space.shrink(joinExtent.value(), EndJoin - StartJoin);
     
     // print statistics
     std::string s = "Statistics for Nested Join with ";
@@ -85,14 +99,94 @@ auto testing(bool DiskAccessStrategy, int BufferReplacementStategy, bool Outer)
 
 
     // store the result
-    storeResult<JoinEmployeeCompany>(buffer, StartJoin, EndJoin, RES_DIR + "nest_join_joined__data_" + (BufferReplacementStategy == LRU ? "lru_" : "mru_") + (DiskAccessStrategy == RANDOM ? "rand_" : "seq_") + (Outer == EMPLOYEE ? "emp" : "comp") + ".csv");
+    storeResult<JoinEmployeeCompany>(buffer, StartJoin, EndJoin, RES_DIR + "nest_join_joined__data_" + (BufferReplacementStategy == LRU ? "lru_" : "mru_") + (DiskAccessStrategy == RANDOM ? "rand_" : "seq_") + (Outer == EMPLOYEE ? "emp" : "comp") + ".csv", DRIVER_THREADS);
+    storeColumnar<JoinEmployeeCompany>(buffer, StartJoin, EndJoin, RES_DIR + "nest_join_joined__data_" + (BufferReplacementStategy == LRU ? "lru_" : "mru_") + (DiskAccessStrategy == RANDOM ? "rand_" : "seq_") + (Outer == EMPLOYEE ? "emp" : "comp") + ".col");
 
+    space.release(joinExtent.value());
     return;
 }
 
+// Nested loop join over dictionary encoded relations, employee as outer relation
+auto joinEncoded(BufferManager &buffer, const StringDictionary &employeeNames, const StringDictionary &companyNames, address_id_t StartEmployee, address_id_t EndEmployee, address_id_t StartCompany, address_id_t EndCompany, address_id_t NextUsableAddress) -> std::pair<address_id_t, address_id_t>
+{
+    address_id_t baseAddress = NextUsableAddress;
+    for (RecordCursor<EncodedEmployee> employee(buffer, StartEmployee, EndEmployee); employee.valid(); employee.advance())
+    {
+        const EncodedEmployee &employeeData = employee.get();
+        scanRecords<EncodedCompany>(buffer, StartCompany, EndCompany, [&](std::span<const EncodedCompany> companies, address_id_t) {
+            for (const EncodedCompany &companyData : companies)
+            {
+                if ( keyOf(employeeData) == keyOf(companyData) )
+                {
+                    // only matching tuples are decoded
+                    JoinEmployeeCompany joinData(decodeStrings<Employee>(employeeData, employeeNames), decodeStrings<Company>(companyData, companyNames));
+                    buffer.writeAddress(baseAddress, recordBytes(joinData));
+                    baseAddress += JoinEmployeeCompany::size;
+                }
+            }
+        });
+    }
+    return std::make_pair(NextUsableAddress, baseAddress);
+}
+
+auto testingEncoded(bool DiskAccessStrategy, int BufferReplacementStategy) -> void
+{
+    Disk disk(DiskAccessStrategy, BLOCK_SIZE, DISK_SIZE);
+    BufferManager buffer(&disk, BufferReplacementStategy, BUFFER_SIZE);
+    SpaceManager space(&buffer);
+
+    auto stat = buffer.getStats();
+
+    // Each table gets a dictionary sized for the worst case and encoded records a fifth the size of the originals
+    const auto numEmployees = (EndAddressEmployee - StartAddressEmployee) / EmployeeSize;
+    const auto numCompanies = (EndAddressCompany - StartAddressCompany) / CompanySize;
+    auto employeeDictExtent = space.allocate(BLOCK_SIZE + numEmployees * (sizeof(Employee::fname) + sizeof(Employee::lname)));
+    auto companyDictExtent = space.allocate(BLOCK_SIZE + numCompanies * (sizeof(Company::name) + sizeof(Company::slogan)));
+    auto employeeExtent = space.allocate(numEmployees * sizeof(EncodedEmployee));
+    auto companyExtent = space.allocate(numCompanies * sizeof(EncodedCompany));
+    if (!employeeDictExtent || !companyDictExtent || !employeeExtent || !companyExtent)
+    {
+        std::cerr << "Not enough free space for the encoded relations" << std::endl;
+        return;
+    }
+    std::optional<Extent> joinExtent;
+    {
+        StringDictionary employeeNames(&buffer, employeeDictExtent.value(), true);
+        StringDictionary companyNames(&buffer, companyDictExtent.value(), true);
+        auto EndEmployee = encodeRelation<Employee>(buffer, employeeNames, StartAddressEmployee, EndAddressEmployee, employeeExtent->start);
+        auto EndCompany = encodeRelation<Company>(buffer, companyNames, StartAddressCompany, EndAddressCompany, companyExtent->start);
+        employeeNames.save();
+        companyNames.save();
+        buffer.printStats(outFile, stat, "Statistics for Dictionary Encoding of both relations");
+        stat = buffer.getStats();
+
+        joinExtent = space.allocateLargest();
+        if (!joinExtent.has_value())
+        {
+            std::cerr << "Not enough free space for the join result" << std::endl;
+            return;
+        }
+        auto [StartJoin, EndJoin] = joinEncoded(buffer, employeeNames, companyNames, employeeExtent->start, EndEmployee, companyExtent->start, EndCompany, joinExtent->start);
+        space.shrink(joinExtent.value(), EndJoin - StartJoin);
+        buffer.printStats(outFile, stat, "Statistics for Nested Join over dictionary encoded relations with Employee as outer relation");
+
+        storeResult<JoinEmployeeCompany>(buffer, StartJoin, EndJoin, RES_DIR + "nest_join_encoded_data_" + (BufferReplacementStategy == LRU ? "lru_" : "mru_") + (DiskAccessStrategy == RANDOM ? "rand" : "seq") + ".csv", DRIVER_THREADS);
+    }
+
+    space.release(joinExtent.value());
+    space.release(companyExtent.value());
+    space.release(employeeExtent.value());
+    space.release(companyDictExtent.value());
+    space.release(employeeDictExtent.value());
+}
+
 int main()
 {
-    auto [a,b,c,d] = loadData();
+    auto [a,b,c,d] = loadData(4 KB, 4 MB, 64 KB, [](address_id_t address, std::span<const std::byte> data) {
+        employeeZones.observe(address, data);
+    }, [](address_id_t address, std::span<const std::byte> data) {
+        companyZones.observe(address, data);
+    });
     StartAddressEmployee = a;
     EndAddressEmployee = b;
     StartAddressCompany = c;
@@ -112,6 +206,10 @@ int main()
     testing(RANDOM, MRU, COMPANY);
     testing(SEQUENTIAL, LRU, COMPANY);
     testing(SEQUENTIAL, MRU, COMPANY);
+    testingEncoded(RANDOM, LRU);
+    testingEncoded(RANDOM, MRU);
+    testingEncoded(SEQUENTIAL, LRU);
+    testingEncoded(SEQUENTIAL, MRU);
 
     std::cout << "Statistics saved to " << RES_DIR + "nested_join_stats.txt" << std::endl;
     return 0;
@@ -2,29 +2,54 @@
 #include <Indexes/BPlusTreeIndex.hpp>
 #include <Storage/BufferManager.hpp>
 #include <Storage/Disk.hpp>
+#include <Storage/SpaceManager.hpp>
+#include <Storage/RecordView.hpp>
+#include <Storage/PaxFile.hpp>
 #include <Utilities/Utils.hpp>
+#include <Utilities/Schema.hpp>
+#include <Utilities/ZoneMap.hpp>
+#include <Utilities/Predicate.hpp>
+#include <Execution/Operators.hpp>
+#include <Execution/ParallelScan.hpp>
+
+#include <iostream>
 
 address_id_t empStartAddr, empEndAddr, compStartAddr, compEndAddr;
 
+// salary, company id and id summaries of the employee pages, built while loading
+ZoneMap<Employee> empZones(BLOCK_SIZE, {fieldIndex<&Employee::salary>(), fieldIndex<&Employee::company_id>(), fieldIndex<&Employee::id>()});
+
 std::ofstream iterRes(RES_DIR + "queryiter_results.txt", std::ios::out | std::ios::trunc);
 std::ofstream bptRes(RES_DIR + "querybpt_results.txt", std::ios::out | std::ios::trunc);
+std::ofstream paxRes(RES_DIR + "querypax_results.txt", std::ios::out | std::ios::trunc);
+std::ofstream pipeRes(RES_DIR + "querypipe_results.txt", std::ios::out | std::ios::trunc);
 std::ofstream iterStats(STAT_DIR + "queryiter_stats.txt", std::ios::out | std::ios::trunc);
 std::ofstream bptStats(STAT_DIR + "querybpt_stats.txt", std::ios::out | std::ios::trunc);
+std::ofstream paxStats(STAT_DIR + "querypax_stats.txt", std::ios::out | std::ios::trunc);
+std::ofstream pipeStats(STAT_DIR + "querypipe_stats.txt", std::ios::out | std::ios::trunc);
 
-void usingBPT(int accessType, int replaceStrat, address_id_t compEndAddr)
+void usingBPT(int accessType, int replaceStrat)
 {
     Disk disk(accessType, BLOCK_SIZE, DISK_SIZE);
     BufferManager bm(&disk, replaceStrat, BUFFER_SIZE);
+    SpaceManager space(&bm);
 
-    // create BPlusTree index
-    BPlusTreeIndex<int, int> empIndex(&bm, 7, compEndAddr);
+    // create BPlusTree index in the largest free extent, trimmed once built
+    auto indexExtent = space.allocateLargest();
+    if (!indexExtent.has_value())
+    {
+        std::cerr << "Not enough free space for the index" << std::endl;
+        return;
+    }
+    BPlusTreeIndex<int, int> empIndex(&bm, 7, indexExtent->start);
     // create index on salary of employee
-    for (int i = 0; i < EMP_SIZE; ++i)
+    for (RecordCursor<Employee> cursor(bm, empStartAddr, empEndAddr); cursor.valid(); cursor.advance())
     {
-        address_id_t addr = empStartAddr + i * sizeof(Employee);
-        Employee emp = extractData<Employee>(bm.readAddress(addr, sizeof(Employee)));
-        empIndex.insert(emp.salary * (EMP_SIZE + 1) + emp.id, addr);
+        const Employee &emp = cursor.get();
+        empIndex.insert(emp.salary * (EMP_SIZE + 1) + emp.id, cursor.address());
     }
+    auto [indexStart, indexEnd] = empIndex.getAddressRange();
+    space.shrink(indexExtent.value(), indexEnd - indexStart);
 
     Stats stat = {0, 0, 0};
     bm.printStats(bptStats, stat, "Statistics for the creation of B+ Tree Index");
@@ -47,11 +72,12 @@ void usingBPT(int accessType, int replaceStrat, address_id_t compEndAddr)
     for (const auto &entry : result)
     {
         auto [key, addr] = entry;
-        Employee emp = extractData<Employee>(bm.readAddress(addr, sizeof(Employee)));
-        bptRes << emp.toString() << std::endl;
+        auto emp = viewRecord<Employee>(bm, addr);
+        bptRes << formatRecord(emp.get()) << std::endl;
     }
 
     bm.printStats(bptStats, stat, "Statistics for query using B+ Tree Index");
+    space.release(indexExtent.value());
 }
 
 void usingIterating(int accessType, int replaceStrat)
@@ -66,33 +92,127 @@ void usingIterating(int accessType, int replaceStrat)
 
     iterRes.clear();
     iterRes.seekp(0, std::ios::beg);
-    for (int i = 0; i < EMP_SIZE; ++i)
+    // pages whose salaries all lie outside the range are skipped without being read
+    // the salaries of a page are compared in place by the batch kernel, only the selected records are formatted
+    std::vector<uint32_t> selection;
+    auto skipped = empZones.scan(bm, empStartAddr, empEndAddr, fieldIndex<&Employee::salary>(), low, high - 1, [&](std::span<const Employee> emps, address_id_t) {
+        selection.resize(std::max(selection.size(), emps.size()));
+        size_t selected = selectRange<&Employee::salary>(emps, low, high - 1, selection.data());
+        for (size_t i = 0; i < selected; ++i)
+        {
+            iterRes << formatRecord(emps[selection[i]]) << std::endl;
+        }
+    });
+
+    bm.printStats(iterStats, stat, "Statistics for the query using Iterating Method, " + std::to_string(skipped) + " pages skipped by the zone map");
+}
+
+void usingColumnScan(int accessType, int replaceStrat)
+{
+    Disk disk(accessType, BLOCK_SIZE, DISK_SIZE);
+    BufferManager bm(&disk, replaceStrat, BUFFER_SIZE);
+    SpaceManager space(&bm);
+
+    // copy the employees into a PAX file, column by column within each page
+    auto paxExtent = space.allocate(PaxFile<Employee>::requiredSize((empEndAddr - empStartAddr) / sizeof(Employee), BLOCK_SIZE));
+    if (!paxExtent.has_value())
+    {
+        std::cerr << "Not enough free space for the PAX file" << std::endl;
+        return;
+    }
+    // every PaxFile is closed, writing its header, before the extent is released
+    auto stat = bm.getStats();
+    bool full = false;
     {
-        address_id_t addr = empStartAddr + i * sizeof(Employee);
-        Employee emp = extractData<Employee>(bm.readAddress(addr, sizeof(Employee)));
-        if (emp.salary >= low && emp.salary < high)
+        PaxFile<Employee> pax(&bm, paxExtent.value(), true);
+        for (RecordCursor<Employee> cursor(bm, empStartAddr, empEndAddr); cursor.valid() && !full; cursor.advance())
         {
-            iterRes << emp.toString() << std::endl;
+            full = !pax.append(cursor.get()).has_value();
         }
     }
+    if (full)
+    {
+        std::cerr << "PAX file is full" << std::endl;
+        space.release(paxExtent.value());
+        return;
+    }
+    bm.printStats(paxStats, stat, "Statistics for the creation of the PAX file");
 
-    bm.printStats(iterStats, stat, "Statistics for the query using Iterating Method");
+    // print all employee id whose salary is between 40000 and 70000, reading only the salary column
+    stat = bm.getStats();
+    {
+        int low = 40000, high = 42001;
+        PaxFile<Employee> pax(&bm, paxExtent.value(), false);
+        std::vector<RecordId> matches;
+        std::vector<uint32_t> selection;
+        pax.scanColumnAs<int>(fieldIndex<&Employee::salary>(), [&](page_id_t page, std::span<const int> salaries) {
+            selection.resize(std::max(selection.size(), salaries.size()));
+            size_t selected = selectRange(salaries, low, high - 1, selection.data());
+            for (size_t i = 0; i < selected; ++i)
+            {
+                matches.push_back({page, selection[i]});
+            }
+        });
+
+        paxRes.clear();
+        paxRes.seekp(0, std::ios::beg);
+        for (const auto &rid : matches)
+        {
+            paxRes << formatRecord(pax.get(rid).value()) << std::endl;
+        }
+    }
+
+    bm.printStats(paxStats, stat, "Statistics for the query using a PAX column scan");
+    space.release(paxExtent.value());
+}
+
+void usingPipeline(int accessType, int replaceStrat)
+{
+    Disk disk(accessType, BLOCK_SIZE, DISK_SIZE);
+    BufferManager bm(&disk, replaceStrat, BUFFER_SIZE);
+
+    auto stat = bm.getStats();
+
+    // print all employee id whose salary is between 40000 and 70000, every morsel's scan feeds its own filter batch by batch
+    int low = 40000, high = 42001;
+    auto emps = parallelPipeline<Employee, Employee>(bm, empStartAddr, empEndAddr, DRIVER_THREADS, [&](OperatorPtr<Employee> morsel) -> OperatorPtr<Employee> {
+        return std::make_unique<RangeFilter<&Employee::salary>>(std::move(morsel), low, high - 1);
+    });
+
+    pipeRes.clear();
+    pipeRes.seekp(0, std::ios::beg);
+    for (const Employee &emp : emps)
+    {
+        pipeRes << formatRecord(emp) << std::endl;
+    }
+
+    bm.printStats(pipeStats, stat, "Statistics for the query using a parallel operator pipeline");
 }
 
 int main()
 {
-    auto [a, b, c, d] = loadData(4 KB, 4 MB, 64 KB);
+    auto [a, b, c, d] = loadData(4 KB, 4 MB, 64 KB, [](address_id_t address, std::span<const std::byte> data) {
+        empZones.observe(address, data);
+    });
     empStartAddr = a;
     empEndAddr = b;
     compStartAddr = c;
     compEndAddr = d;
 
-    usingBPT(RANDOM, LRU, compEndAddr);
-    usingBPT(SEQUENTIAL, LRU, compEndAddr);
-    usingBPT(RANDOM, MRU, compEndAddr);
-    usingBPT(SEQUENTIAL, MRU, compEndAddr);
+    usingBPT(RANDOM, LRU);
+    usingBPT(SEQUENTIAL, LRU);
+    usingBPT(RANDOM, MRU);
+    usingBPT(SEQUENTIAL, MRU);
     usingIterating(RANDOM, LRU);
     usingIterating(SEQUENTIAL, LRU);
     usingIterating(RANDOM, MRU);
     usingIterating(SEQUENTIAL, MRU);
+    usingColumnScan(RANDOM, LRU);
+    usingColumnScan(SEQUENTIAL, LRU);
+    usingColumnScan(RANDOM, MRU);
+    usingColumnScan(SEQUENTIAL, MRU);
+    usingPipeline(RANDOM, LRU);
+    usingPipeline(SEQUENTIAL, LRU);
+    usingPipeline(RANDOM, MRU);
+    usingPipeline(SEQUENTIAL, MRU);
 }
\ No newline at end of file
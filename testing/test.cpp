@@ -2,9 +2,25 @@
 #include <Indexes/BPlusTreeIndex.hpp>
 #include <Storage/Disk.hpp>
 #include <Indexes/HashIndex.hpp>
+#include <Storage/SpaceManager.hpp>
+#include <Storage/HeapFile.hpp>
+#include <Storage/StringDictionary.hpp>
+#include <Utilities/Schema.hpp>
+#include <Utilities/ColumnarFile.hpp>
+#include <Utilities/ZoneMap.hpp>
+#include <Utilities/Predicate.hpp>
+#include <Execution/Operators.hpp>
+#include <Execution/ParallelScan.hpp>
+#include <Execution/ExternalSorter.hpp>
+#include <Execution/GraceHashJoin.hpp>
+#include <Utilities/TaskScheduler.hpp>
+#include <Utilities/LoserTree.hpp>
+#include <Utilities/KeySort.hpp>
 #include <iostream>
 #include <vector> 
 #include <set>
+#include <thread>
+#include <chrono>
 #include <optional>
 
 // using KeyType = std::string;
@@ -280,8 +296,624 @@ void testSplitAndMerge(ExtendableHashIndex<int,int> &index)
     std::cout << "Global Depth After Deletes: " << index.getGlobalDepth() << std::endl;
 }
 
+void testSpaceManager()
+{
+    std::cout << "\n=== Space Manager Test ===\n";
+    Disk spaceDisk( RANDOM, 512, 16 * 512, "space_test.dat" );
+    {
+        BufferManager spaceBm( &spaceDisk, LRU, 4 * 512 );
+        SpaceManager space( &spaceBm );
+        space.format();
+        std::cout << "Free blocks after format: " << space.getFreeBlocks() << std::endl;
+
+        auto a = space.allocate( 1000 );
+        auto b = space.allocate( 512 );
+        std::cout << "Allocated a: [" << a->start << ", " << a->end() << ")" << std::endl;
+        std::cout << "Allocated b: [" << b->start << ", " << b->end() << ")" << std::endl;
+
+        space.release( a.value() );
+        auto c = space.allocate( 100 );
+        std::cout << "Reused freed space for c: [" << c->start << ", " << c->end() << ")" << std::endl;
+
+        auto d = space.allocateLargest();
+        space.shrink( d.value(), 600 );
+        std::cout << "Largest extent shrunk to: [" << d->start << ", " << d->end() << ")" << std::endl;
+    }
+    {
+        BufferManager spaceBm( &spaceDisk, LRU, 4 * 512 );
+        SpaceManager space( &spaceBm );
+        std::cout << "Free blocks after reopening: " << space.getFreeBlocks() << std::endl;
+    }
+}
+
+void testBufferWarmup()
+{
+    std::cout << "\n--- Testing Buffer Warm-up ---" << std::endl;
+    std::remove( "warmup_test.dat" );
+    std::remove( "warmup_test.hot" );
+    {
+        Disk warmDisk( RANDOM, 512, 512 * 32, "warmup_test.dat" );
+        BufferManager warmBm( &warmDisk, LRU, 8 * 512 );
+        warmBm.enableWarmup( "warmup_test.hot" );
+        for ( int page = 0; page < 8; ++page )
+        {
+            warmBm.writeAddress( page * 512, std::vector<std::byte>( 512, std::byte( page ) ) );
+        }
+    }
+
+    // the pool of the reopened buffer manager starts empty, the saved pages are read ahead in the background
+    Disk warmDisk( RANDOM, 512, 512 * 32, "warmup_test.dat" );
+    BufferManager warmBm( &warmDisk, LRU, 8 * 512 );
+    warmBm.enableWarmup( "warmup_test.hot" );
+    while ( warmBm.getNumWarmReads() < 8 )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    warmBm.writePages( 5, std::vector<std::byte>( 512, std::byte( 42 ) ) );
+
+    auto diskReads = warmBm.getNumIO();
+    bool intact = true;
+    for ( int page = 0; page < 5; ++page )
+    {
+        intact &= warmBm.readAddress( page * 512, 512 ) == std::vector<std::byte>( 512, std::byte( page ) );
+    }
+    std::cout << "Disk reads for 5 warm pages: " << warmBm.getNumIO() - diskReads << ", contents intact: " << ( intact ? "Yes" : "No" ) << std::endl;
+    bool rewritten = warmBm.readAddress( 5 * 512, 512 ) == std::vector<std::byte>( 512, std::byte( 42 ) );
+    std::cout << "Rewritten page read from the disk: " << ( rewritten ? "Yes" : "No" ) << std::endl;
+
+    // a sidecar in a missing directory cannot be saved, the dirty page is still flushed on shutdown
+    {
+        Disk lostDisk( RANDOM, 512, 512 * 32, "warmup_test.dat" );
+        BufferManager lostBm( &lostDisk, LRU, 8 * 512 );
+        lostBm.enableWarmup( "missing_dir/warmup_test.hot" );
+        lostBm.writeAddress( 6 * 512, std::vector<std::byte>( 512, std::byte( 66 ) ) );
+    }
+    Disk checkDisk( RANDOM, 512, 512 * 32, "warmup_test.dat" );
+    BufferManager checkBm( &checkDisk, LRU, 8 * 512 );
+    bool flushed = checkBm.readAddress( 6 * 512, 512 ) == std::vector<std::byte>( 512, std::byte( 66 ) );
+    std::cout << "Dirty page flushed without a writable sidecar: " << ( flushed ? "Yes" : "No" ) << std::endl;
+}
+
+void testCompressedTier()
+{
+    std::cout << "\n--- Testing Compressed Tier ---" << std::endl;
+    std::vector<std::byte> block( 512 );
+    for ( size_t i = 0; i < block.size(); ++i )
+    {
+        block[i] = std::byte( i % 64 < 48 ? 0 : ( i * 31 ) % 251 );
+    }
+    auto compressed = compressBlock( block );
+    std::cout << "Codec round trip: " << ( decompressBlock( compressed, block.size() ) == block ? "Yes" : "No" ) << ", " << block.size() << " -> " << compressed.size() << " bytes" << std::endl;
+
+    std::remove( "tier_test.dat" );
+    Disk tierDisk( RANDOM, 512, 512 * 16, "tier_test.dat" );
+    BufferManager tierBm( &tierDisk, LRU, 2 * 512 );
+    tierBm.enableCompressedTier( 8 * 512 );
+    for ( int page = 0; page < 4; ++page )
+    {
+        block[0] = std::byte( page );
+        tierBm.writeAddress( page * 512, block );
+    }
+
+    // pages 0 and 1 were evicted to make room for 2 and 3, reading 0 back only writes out the dirty page it evicts
+    auto diskAccesses = tierBm.getNumIO();
+    auto data = tierBm.readAddress( 0, 512 );
+    block[0] = std::byte( 0 );
+    std::cout << "Evicted page served from the tier: " << ( tierBm.getNumTierHits() == 1 && tierBm.getNumIO() - diskAccesses == 1 ? "Yes" : "No" ) << ", contents intact: " << ( data == block ? "Yes" : "No" ) << std::endl;
+}
+
+void testHeapFile()
+{
+    std::cout << "\n=== Heap File Test ===\n";
+    Disk heapDisk( RANDOM, 512, 16 * 512, "heap_test.dat" );
+    BufferManager heapBm( &heapDisk, LRU, 4 * 512 );
+    SpaceManager space( &heapBm );
+    space.format();
+    Extent extent = space.allocate( 8 * 512 ).value();
+    HeapFile heap( &heapBm, extent, true );
+
+    std::vector<RecordId> rids;
+    for ( int i = 0; i < 20; ++i )
+    {
+        Employee emp{};
+        emp.id = i;
+        emp.company_id = i % 3;
+        emp.salary = 1000 * i;
+        std::string name = "Name" + std::string( i % 5, 'x' );
+        std::copy( name.begin(), name.end(), emp.fname.begin() );
+        std::copy( name.begin(), name.end(), emp.lname.begin() );
+        rids.push_back( heap.insert( encodeRecord( emp ) ).value() );
+    }
+    std::cout << "Inserted 20 employees into " << heap.getNumPages() << " pages" << std::endl;
+
+    heap.remove( rids[3] );
+    std::cout << "Read deleted record: " << ( heap.read( rids[3] ).has_value() ? "Found" : "Not Found" ) << std::endl;
+
+    Employee emp = decodeRecord<Employee>( heap.read( rids[7] ).value() );
+    std::string longName( 50, 'y' );
+    std::copy( longName.begin(), longName.end(), emp.lname.begin() );
+    std::cout << "Grow record 7 in place: " << ( heap.update( rids[7], encodeRecord( emp ) ) ? "Updated" : "Failed" ) << std::endl;
+    std::cout << "Record 7 after update: " << formatRecord( decodeRecord<Employee>( heap.read( rids[7] ).value() ) ) << std::endl;
+
+    Employee full{};
+    full.fname.fill( 'z' );
+    std::cout << "Full name array round trip: " << ( decodeRecord<Employee>( encodeRecord( full ) ).fname == full.fname ? "Yes" : "No" ) << std::endl;
+
+    int count = 0;
+    heap.scan( [&count]( RecordId, std::span<const std::byte> ) { ++count; } );
+    std::cout << "Records found by scan: " << count << std::endl;
+
+    count = 0;
+    HeapFile reopened( &heapBm, extent, false );
+    reopened.scan( [&count]( RecordId, std::span<const std::byte> ) { ++count; } );
+    std::cout << "Records found after reopening: " << count << std::endl;
+}
+
+void testStringDictionary()
+{
+    std::cout << "\n--- Testing String Dictionary ---" << std::endl;
+    std::remove( "dict_test.dat" );
+    Disk dictDisk( RANDOM, 512, 512 * 64, "dict_test.dat" );
+    BufferManager dictBm( &dictDisk, LRU, 4 * 512 );
+    SpaceManager space( &dictBm );
+    space.format();
+    Extent extent = space.allocate( 4 * 512 ).value();
+    {
+        StringDictionary dictionary( &dictBm, extent, true );
+        for ( std::string name : { "Alice", "Bob", "Alice", "Carol", "Bob" } )
+        {
+            std::cout << name << " -> " << dictionary.encode( name ) << std::endl;
+        }
+    }
+    StringDictionary reopened( &dictBm, extent, false );
+    std::cout << "Entries after reopening: " << reopened.size() << ", code 2 is " << reopened.decode( 2 ) << std::endl;
+    std::cout << "Find Dave: " << ( reopened.find( "Dave" ).has_value() ? "Found" : "Not Found" ) << std::endl;
+}
+
+void testColumnarFile()
+{
+    std::cout << "\n--- Testing Columnar File ---" << std::endl;
+    std::remove( "columnar_test.dat" );
+    Disk colDisk( RANDOM, 512, 512 * 64, "columnar_test.dat" );
+    BufferManager colBm( &colDisk, LRU, 4 * 512 );
+
+    const int count = 100;
+    for ( int i = 0; i < count; ++i )
+    {
+        Employee emp{};
+        emp.id = 1000 + i;
+        emp.company_id = i % 7;
+        emp.salary = 50000 - 37 * i;
+        std::string name = "Name" + std::to_string( i % 4 );
+        std::copy( name.begin(), name.end(), emp.fname.begin() );
+        std::copy( name.begin(), name.end(), emp.lname.begin() );
+        // one last name fills its whole array, with no terminating NUL
+        if ( i == count - 1 )
+        {
+            emp.lname.fill( 'z' );
+        }
+        colBm.writeAddress( i * sizeof( Employee ), recordBytes( emp ) );
+    }
+    storeColumnar<Employee>( colBm, 0, count * sizeof( Employee ), "columnar_test.col" );
+
+    ColumnarFile file( "columnar_test.col" );
+    const auto &salary = file.getChunk( 0, fieldIndex<&Employee::salary>() );
+    std::cout << "Rows: " << file.getNumRows() << ", blocks: " << file.getNumBlocks() << ", fname dictionary size: " << file.getColumns()[fieldIndex<&Employee::fname>()].dictCount << std::endl;
+    std::cout << "Salary range of block 0: " << salary.min << " - " << salary.max << std::endl;
+
+    address_id_t copy = 32 * 512;
+    auto end = file.load<Employee>( colBm, copy );
+    bool same = end == copy + count * sizeof( Employee ) && colBm.readAddress( 0, count * sizeof( Employee ) ) == colBm.readAddress( copy, count * sizeof( Employee ) );
+    std::cout << "Loaded records match the originals: " << ( same ? "Yes" : "No" ) << std::endl;
+
+    // point the second fname entry far past the end of the file
+    std::ifstream in( "columnar_test.col", std::ios::binary );
+    std::vector<char> bytes( ( std::istreambuf_iterator<char>( in ) ), std::istreambuf_iterator<char>() );
+    uint32_t farOffset = 1u << 30;
+    std::memcpy( bytes.data() + file.getColumns()[fieldIndex<&Employee::fname>()].dictOffset + 2 * sizeof( uint32_t ), &farOffset, sizeof( farOffset ) );
+    std::ofstream( "columnar_corrupt.col", std::ios::binary ).write( bytes.data(), bytes.size() );
+    try
+    {
+        ColumnarFile corrupt( "columnar_corrupt.col" );
+        std::cout << "Corrupt dictionary rejected: No" << std::endl;
+    }
+    catch ( const std::runtime_error & )
+    {
+        std::cout << "Corrupt dictionary rejected: Yes" << std::endl;
+    }
+}
+
+void testZoneMap()
+{
+    std::cout << "\n--- Testing Zone Map ---" << std::endl;
+    std::remove( "zone_test.dat" );
+    Disk zoneDisk( RANDOM, 512, 512 * 64, "zone_test.dat" );
+    BufferManager zoneBm( &zoneDisk, LRU, 4 * 512 );
+
+    // salaries ascend, and records start mid page so some straddle two pages
+    const int count = 100;
+    const address_id_t start = 64, end = start + count * sizeof( Employee );
+    ZoneMap<Employee> written( 512, { fieldIndex<&Employee::salary>() } );
+    ZoneMap<Employee> observed( 512, { fieldIndex<&Employee::salary>() } );
+    std::vector<std::byte> bytes;
+    for ( int i = 0; i < count; ++i )
+    {
+        Employee emp{};
+        emp.id = i;
+        emp.salary = 1000 + 10 * i;
+        zoneBm.writeAddress( start + i * sizeof( Employee ), recordBytes( emp ) );
+        written.add( start + i * sizeof( Employee ), emp );
+        auto record = recordBytes( emp );
+        bytes.insert( bytes.end(), record.begin(), record.end() );
+    }
+    // chunks that split records, as the loader hands them out
+    for ( size_t offset = 0; offset < bytes.size(); offset += 300 )
+    {
+        observed.observe( start + offset, std::span<const std::byte>( bytes ).subspan( offset, std::min<size_t>( 300, bytes.size() - offset ) ) );
+    }
+
+    for ( ZoneMap<Employee> *zones : { &written, &observed } )
+    {
+        int matches = 0;
+        auto skipped = zones->scan( zoneBm, start, end, fieldIndex<&Employee::salary>(), 1500, 1590, [&]( std::span<const Employee> emps, address_id_t ) {
+            for ( const Employee &emp : emps )
+            {
+                matches += emp.salary >= 1500 && emp.salary <= 1590;
+            }
+        } );
+        std::cout << "Matches: " << matches << ", pages skipped: " << skipped << std::endl;
+    }
+}
+
+void testPredicateKernel()
+{
+    std::cout << "\n--- Testing Predicate Kernel (" << predicateKernel() << ") ---" << std::endl;
+    std::vector<Employee> emps( 1000 );
+    std::vector<int32_t> salaries( emps.size() );
+    for ( size_t i = 0; i < emps.size(); ++i )
+    {
+        emps[i].salary = salaries[i] = static_cast<int32_t>( ( i * 7919 ) % 1000 );
+    }
+
+    std::vector<uint32_t> expected( emps.size() ), fromRecords( emps.size() ), fromColumn( emps.size() );
+    auto salaryBytes = reinterpret_cast<const std::byte *>( emps.data() ) + offsetof( Employee, salary );
+    size_t numExpected = selectRangeScalar( salaryBytes, emps.size(), sizeof( Employee ), 250, 499, expected.data() );
+    size_t numRecords = selectRange<&Employee::salary>( std::span<const Employee>( emps ), 250, 499, fromRecords.data() );
+    size_t numColumn = selectRange( std::span<const int32_t>( salaries ), 250, 499, fromColumn.data() );
+    bool same = numRecords == numExpected && numColumn == numExpected
+        && std::equal( expected.begin(), expected.begin() + numExpected, fromRecords.begin() )
+        && std::equal( expected.begin(), expected.begin() + numExpected, fromColumn.begin() );
+    std::cout << "Selected " << numExpected << " of " << emps.size() << ", kernels agree: " << ( same ? "Yes" : "No" ) << std::endl;
+    std::cout << "Salaries below 10: " << selectCompare( salaryBytes, emps.size(), sizeof( Employee ), CompareOp::LESS, 10, expected.data() ) << std::endl;
+}
+
+void testOperators()
+{
+    std::cout << "\n--- Testing Operators ---" << std::endl;
+    std::remove( "operator_test.dat" );
+    Disk opDisk( RANDOM, 512, 512 * 2048, "operator_test.dat" );
+    BufferManager opBm( &opDisk, LRU, 8 * 512 );
+
+    // 3000 employees over companies 0 - 9, companies stored in descending id order
+    const int numEmployees = 3000, numCompanies = 10;
+    const address_id_t empStart = 0, empEnd = numEmployees * sizeof( Employee );
+    const address_id_t compStart = empEnd, compEnd = compStart + numCompanies * sizeof( Company );
+    for ( int i = 0; i < numEmployees; ++i )
+    {
+        Employee emp{};
+        emp.id = i;
+        emp.company_id = ( i * 7 ) % numCompanies;
+        emp.salary = 1000 + i;
+        opBm.writeAddress( empStart + i * sizeof( Employee ), recordBytes( emp ) );
+    }
+    for ( int i = 0; i < numCompanies; ++i )
+    {
+        Company comp{};
+        comp.id = numCompanies - 1 - i;
+        opBm.writeAddress( compStart + i * sizeof( Company ), recordBytes( comp ) );
+    }
+    auto employees = [&] { return std::make_unique<Scan<Employee>>( opBm, empStart, empEnd ); };
+    auto companies = [&] { return std::make_unique<Scan<Company>>( opBm, compStart, compEnd ); };
+    auto count = []( auto &op ) {
+        size_t rows = 0;
+        drain( op, [&]( auto batch ) { rows += batch.size(); } );
+        return rows;
+    };
+
+    HashJoin<Employee, Company, JoinEmployeeCompany> hashJoin( employees(), companies() );
+    NestedLoopJoin<Employee, Company, JoinEmployeeCompany> nestedJoin( employees(), companies() );
+    MergeJoin<Employee, Company, JoinEmployeeCompany> mergeJoin( std::make_unique<Sort<Employee>>( employees() ), std::make_unique<Sort<Company>>( companies() ) );
+    std::cout << "Join rows (hash, nested loop, merge): " << count( hashJoin ) << ", " << count( nestedJoin ) << ", " << count( mergeJoin ) << std::endl;
+
+    RangeFilter<&Employee::salary> rangeFilter( employees(), 1500, 1599 );
+    Filter<Employee> filter( employees(), []( const Employee &emp ) { return emp.company_id == 3; } );
+    Limit<Employee> limit( employees(), 1500 );
+    Project<Employee, int> project( employees(), []( const Employee &emp ) { return emp.salary; } );
+    std::cout << "Range filter: " << count( rangeFilter ) << ", filter: " << count( filter ) << ", limit: " << count( limit ) << ", project: " << count( project ) << std::endl;
+
+    BPlusTreeIndex<int, int> salaryIndex( &opBm, 7, compEnd );
+    for ( int i = 0; i < numEmployees; ++i )
+    {
+        salaryIndex.insert( 1000 + i, empStart + i * sizeof( Employee ) );
+    }
+    auto indexScan = makeIndexScan<Employee>( opBm, salaryIndex, 2000, 2009 );
+    std::cout << "Index scan: " << count( *indexScan ) << std::endl;
+}
+
+void testParallelScan()
+{
+    std::cout << "\n--- Testing Parallel Scan ---" << std::endl;
+    std::remove( "parallel_test.dat" );
+    Disk scanDisk( RANDOM, 512, 512 * 2048, "parallel_test.dat" );
+    BufferManager scanBm( &scanDisk, LRU, 16 * 512 );
+
+    // records start mid page, so morsel boundaries fall inside records
+    const int count = 5000;
+    const address_id_t start = 64, end = start + count * sizeof( Employee );
+    for ( int i = 0; i < count; ++i )
+    {
+        Employee emp{};
+        emp.id = i;
+        emp.salary = ( i * 7919 ) % 10000;
+        scanBm.writeAddress( start + i * sizeof( Employee ), recordBytes( emp ) );
+    }
+
+    std::atomic<long long> idSum = 0;
+    parallelScan<Employee>( scanBm, start, end, 4, [&]( unsigned, std::span<const Employee> emps, address_id_t ) {
+        for ( const Employee &emp : emps )
+        {
+            idSum += emp.id;
+        }
+    } );
+    auto selected = parallelPipeline<Employee, Employee>( scanBm, start, end, 4, []( OperatorPtr<Employee> morsel ) -> OperatorPtr<Employee> {
+        return std::make_unique<RangeFilter<&Employee::salary>>( std::move( morsel ), 0, 999 );
+    } );
+    bool ordered = std::is_sorted( selected.begin(), selected.end(), []( const Employee &a, const Employee &b ) { return a.id < b.id; } );
+    std::cout << "Id sum: " << idSum << " (expected " << 1LL * count * ( count - 1 ) / 2 << "), selected: " << selected.size() << ", in order: " << ( ordered ? "Yes" : "No" ) << std::endl;
+}
+
+void testTaskScheduler()
+{
+    std::cout << "\n--- Testing Task Scheduler ---" << std::endl;
+    TaskScheduler scheduler( 3 );
+
+    // tasks spawn and wait for tasks of their own, waiting threads run queued tasks meanwhile
+    std::atomic<int> leaves = 0;
+    TaskGroup outer( scheduler );
+    for ( int i = 0; i < 8; ++i )
+    {
+        outer.run( [&]() {
+            TaskGroup inner( scheduler );
+            for ( int j = 0; j < 8; ++j )
+            {
+                inner.run( [&]() { ++leaves; } );
+            }
+            inner.wait();
+        } );
+    }
+    outer.wait();
+    auto answer = scheduler.submit( []() { return 6 * 7; } );
+    std::cout << "Workers: " << scheduler.getNumWorkers() << ", nested tasks run: " << leaves << ", future: " << scheduler.get( answer ) << std::endl;
+
+    // the failing task cancels its group, and its exception reaches the waiter
+    TaskGroup failing( scheduler );
+    failing.run( []() { throw std::runtime_error( "task failed" ); } );
+    try
+    {
+        failing.wait();
+    }
+    catch ( const std::exception &e )
+    {
+        std::cout << "Caught: " << e.what() << ", cancelled: " << ( failing.isCancelled() ? "Yes" : "No" ) << std::endl;
+    }
+}
+
+void testLoserTree()
+{
+    std::cout << "\n--- Testing Loser Tree ---" << std::endl;
+
+    // 7 sorted runs of (key, run) pairs with many equal keys, one of them empty
+    std::vector<std::vector<std::pair<int, int>>> runs( 7 );
+    for ( int run = 0; run < 6; ++run )
+    {
+        for ( int i = 0; i < 50 + run * 13; ++i )
+        {
+            runs[run].push_back( { ( i * ( run + 3 ) ) / 7, run } );
+        }
+    }
+    std::vector<int> keys;
+    std::vector<bool> exhausted;
+    std::vector<size_t> positions( runs.size(), 0 );
+    for ( const auto &run : runs )
+    {
+        keys.push_back( run.empty() ? 0 : run.front().first );
+        exhausted.push_back( run.empty() );
+    }
+    LoserTree<int> tree( keys, exhausted );
+    std::vector<std::pair<int, int>> merged;
+    while ( !tree.empty() )
+    {
+        size_t run = tree.winner();
+        merged.push_back( runs[run][positions[run]++] );
+        if ( positions[run] < runs[run].size() )
+        {
+            tree.replaceWinner( runs[run][positions[run]].first );
+        }
+        else
+        {
+            tree.exhaustWinner();
+        }
+    }
+    // equal keys must come out in run order
+    bool stable = std::is_sorted( merged.begin(), merged.end() );
+    std::cout << "Merged " << merged.size() << " keys, sorted and stable: " << ( stable ? "Yes" : "No" ) << std::endl;
+}
+
+void testKeyPointerSort()
+{
+    std::cout << "\n--- Testing Key/Pointer Sort ---" << std::endl;
+
+    // negative and repeated keys, the id tells the input order
+    std::vector<Employee> employees( 1000 );
+    for ( int i = 0; i < 1000; ++i )
+    {
+        employees[i].id = i;
+        employees[i].company_id = ( i * 7919 ) % 301 - 150;
+    }
+    // an integer key's prefix is the whole key, so the radix sort alone orders the records
+    SortKey<Employee> key( { sortColumn<&Employee::company_id>() } );
+    std::vector<KeyPointer> entries, scratch;
+    for ( size_t i = 0; i < employees.size(); ++i )
+    {
+        entries.push_back( { key.prefix( employees[i] ), static_cast<uint32_t>( i ) } );
+    }
+    radixSortKeyPointers( entries, scratch );
+    std::vector<Employee> sorted( employees.size() );
+    gatherRecords<Employee>( entries, employees, sorted );
+
+    std::vector<Employee> expected = employees;
+    std::stable_sort( expected.begin(), expected.end(), key );
+    bool same = std::equal( sorted.begin(), sorted.end(), expected.begin(), []( const Employee &lhs, const Employee &rhs ) {
+        return lhs.id == rhs.id;
+    } );
+    std::cout << "Sorted " << sorted.size() << " records, same as a stable sort: " << ( same ? "Yes" : "No" ) << std::endl;
+}
+
+void testExternalSorter()
+{
+    std::cout << "\n--- Testing External Sorter ---" << std::endl;
+    std::remove( "sorter_test.dat" );
+    Disk sortDisk( RANDOM, 512, 512 * 2048, "sorter_test.dat" );
+    BufferManager sortBm( &sortDisk, LRU, 4 * 512 );
+    SpaceManager sortSpace( &sortBm );
+
+    // 2000 employees with repeated first names and salaries, the id tells the input order
+    const int numEmployees = 2000;
+    const char *names[] = { "dee", "ann", "bob", "annabel", "cy" };
+    auto input = sortSpace.allocate( numEmployees * sizeof( Employee ) );
+    std::vector<Employee> expected;
+    for ( int i = 0; i < numEmployees; ++i )
+    {
+        Employee emp{};
+        emp.id = i;
+        emp.company_id = i % 10;
+        emp.salary = ( i * 7919 ) % 97 - 40;
+        std::strncpy( emp.fname.data(), names[( i * 31 ) % 5], emp.fname.size() );
+        sortBm.writeAddress( input->start + i * sizeof( Employee ), recordBytes( emp ) );
+        expected.push_back( emp );
+    }
+
+    // first name ascending then salary descending, a 16 record budget makes many runs and several merge passes,
+    // a 1024 record one sorts each run in slices and merges the two runs in key ranges on several threads
+    SortKey<Employee> key( { sortColumn<&Employee::fname>(), sortColumn<&Employee::salary>( SortOrder::DESCENDING ) } );
+    std::stable_sort( expected.begin(), expected.end(), key );
+    for ( auto [formation, budget] : { std::pair{ RunFormation::KEY_POINTER, 16 }, { RunFormation::REPLACEMENT_SELECTION, 16 }, { RunFormation::KEY_POINTER, 1024 } } )
+    {
+        ExternalSorter<Employee> sorter( sortBm, sortSpace, key, 3 );
+        sorter.setMemoryBudget( budget * sizeof( Employee ) );
+        sorter.setRunFormation( formation );
+        auto sorted = sorter.sort( input->start, input->start + numEmployees * sizeof( Employee ) );
+        bool same = sorted.end - sorted.extent.start == numEmployees * sizeof( Employee );
+        for ( int i = 0; same && i < numEmployees; ++i )
+        {
+            same = extractData<Employee>( sortBm.readAddress( sorted.extent.start + i * sizeof( Employee ), sizeof( Employee ) ) ).id == expected[i].id;
+        }
+        std::cout << ( formation == RunFormation::KEY_POINTER ? "Key/pointer" : "Replacement selection" ) << " runs of " << budget << " records, same as a stable sort: " << ( same ? "Yes" : "No" ) << std::endl;
+        sortSpace.release( sorted.extent );
+    }
+    sortSpace.release( input.value() );
+}
+
+void testGraceHashJoin()
+{
+    std::cout << "\n--- Testing Grace Hash Join ---" << std::endl;
+    std::remove( "grace_test.dat" );
+    Disk joinDisk( RANDOM, 512, 512 * 4096, "grace_test.dat" );
+    BufferManager joinBm( &joinDisk, LRU, 4 * 512 );
+    SpaceManager joinSpace( &joinBm );
+
+    // companies 0 - 199 plus 30 more with id 7, employees over companies 0 - 249 so some find no company
+    const int numEmployees = 1000, numCompanies = 230;
+    auto employees = joinSpace.allocate( numEmployees * sizeof( Employee ) );
+    auto companies = joinSpace.allocate( numCompanies * sizeof( Company ) );
+    std::vector<Company> allCompanies;
+    for ( int i = 0; i < numCompanies; ++i )
+    {
+        Company comp{};
+        comp.id = i < 200 ? i : 7;
+        std::snprintf( comp.name.data(), comp.name.size(), "c%d", i );
+        joinBm.writeAddress( companies->start + i * sizeof( Company ), recordBytes( comp ) );
+        allCompanies.push_back( comp );
+    }
+    std::vector<std::pair<int, std::string>> expected, joined;
+    for ( int i = 0; i < numEmployees; ++i )
+    {
+        Employee emp{};
+        emp.id = i;
+        emp.company_id = ( i * 37 ) % 250;
+        joinBm.writeAddress( employees->start + i * sizeof( Employee ), recordBytes( emp ) );
+        for ( const auto &comp : allCompanies )
+        {
+            if ( comp.id == emp.company_id )
+            {
+                expected.push_back( { emp.id, comp.name.data() } );
+            }
+        }
+    }
+
+    // a budget of 8 companies and a fan-out of 3 make the partitions split again, id 7 never fits
+    GraceHashJoin<Employee, Company, JoinEmployeeCompany> join( joinBm, joinSpace );
+    join.setMemoryBudget( 8 * sizeof( Company ) );
+    join.setFanOut( 3 );
+    auto output = joinSpace.allocate( expected.size() * sizeof( JoinEmployeeCompany ) );
+    size_t freeBlocks = joinSpace.getFreeBlocks();
+    address_id_t end = join.join( employees->start, employees->end(), companies->start, companies->start + numCompanies * sizeof( Company ), output->start );
+    for ( address_id_t address = output->start; address < end; address += sizeof( JoinEmployeeCompany ) )
+    {
+        auto row = extractData<JoinEmployeeCompany>( joinBm.readAddress( address, sizeof( JoinEmployeeCompany ) ) );
+        joined.push_back( { row.employee_id, row.name.data() } );
+    }
+    std::sort( expected.begin(), expected.end() );
+    std::sort( joined.begin(), joined.end() );
+    std::cout << "Joined " << joined.size() << " rows, same as a nested loop: " << ( joined == expected ? "Yes" : "No" ) << ", partitions released: " << ( joinSpace.getFreeBlocks() == freeBlocks ? "Yes" : "No" ) << std::endl;
+
+    // leave just the room of the first level's partitions, 253 employee and 61 company chunks, so a deeper level runs out
+    auto filler = joinSpace.allocateLargest();
+    joinSpace.shrink( filler.value(), filler->size - 314 * 512 );
+    freeBlocks = joinSpace.getFreeBlocks();
+    try
+    {
+        join.join( employees->start, employees->end(), companies->start, companies->start + numCompanies * sizeof( Company ), output->start );
+        std::cout << "Join without space for the partitions failed: No" << std::endl;
+    }
+    catch ( const std::runtime_error & )
+    {
+        std::cout << "Join without space for the partitions failed: Yes, partitions released: " << ( joinSpace.getFreeBlocks() == freeBlocks ? "Yes" : "No" ) << std::endl;
+    }
+    joinSpace.release( filler.value() );
+    joinSpace.release( output.value() );
+    joinSpace.release( companies.value() );
+    joinSpace.release( employees.value() );
+}
+
 int main()
 {
+    testSpaceManager();
+    testBufferWarmup();
+    testCompressedTier();
+    testHeapFile();
+    testStringDictionary();
+    testColumnarFile();
+    testZoneMap();
+    testPredicateKernel();
+    testOperators();
+    testParallelScan();
+    testTaskScheduler();
+    testLoserTree();
+    testKeyPointerSort();
+    testExternalSorter();
+    testGraceHashJoin();
+
     Disk disk( RANDOM, 4096, 1024 );
     BufferManager bm( &disk, LRU, 1024 );
     ExtendableHashIndex<int,int> index(&bm); // Start with global depth 2